@@ -0,0 +1,269 @@
+#ifndef CONCURRENT_VECTOR_HPP
+#define CONCURRENT_VECTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "vector.hpp"
+
+// Вектор для параллельного добавления: элементы лежат в сегментах размером 32, 64, 128, ...
+// и никогда не переезжают. Слот выдается через fetch_add, после постройки элемент публикуется,
+// и Size() - это длина непрерывного опубликованного префикса. Читать [0, Size()) можно
+// одновременно с добавлением.
+template <class T>
+class ConcurrentVector {
+ private:
+  static constexpr size_t kFirstSegmentBits = 5;
+  static constexpr size_t kFirstSegmentSize = size_t{1} << kFirstSegmentBits;
+  static constexpr size_t kMaxSegments = sizeof(size_t) * 8 - kFirstSegmentBits;
+
+  // В одном блоке сначала лежат элементы сегмента, за ними флаги готовности
+  std::atomic<T*> segments_[kMaxSegments] = {};
+  std::atomic<size_t> claimed_{0};
+  std::atomic<size_t> published_{0};
+
+  static size_t SegmentOf(size_t index) {
+    return std::bit_width(index + kFirstSegmentSize) - 1 - kFirstSegmentBits;
+  }
+
+  static size_t SegmentStart(size_t segment) {
+    return (kFirstSegmentSize << segment) - kFirstSegmentSize;
+  }
+
+  static size_t SegmentSize(size_t segment) {
+    return kFirstSegmentSize << segment;
+  }
+
+  static std::atomic<bool>* Flags(T* data, size_t segment) {
+    return reinterpret_cast<std::atomic<bool>*>(reinterpret_cast<unsigned char*>(data) +
+                                                sizeof(T) * SegmentSize(segment));
+  }
+
+  T* EnsureSegment(size_t segment) {
+    T* data = segments_[segment].load(std::memory_order_acquire);
+    if (data) {
+      return data;
+    }
+    const size_t size = SegmentSize(segment);
+    T* fresh = static_cast<T*>(::operator new(size * (sizeof(T) + sizeof(std::atomic<bool>))));
+    std::atomic<bool>* flags = Flags(fresh, segment);
+    for (size_t i = 0; i < size; ++i) {
+      new (flags + i) std::atomic<bool>(false);
+    }
+    if (segments_[segment].compare_exchange_strong(data, fresh, std::memory_order_acq_rel)) {
+      return fresh;
+    }
+    ::operator delete(fresh);
+    return data;
+  }
+
+  bool Ready(size_t index) const {
+    const size_t segment = SegmentOf(index);
+    T* data = segments_[segment].load(std::memory_order_acquire);
+    return data && Flags(data, segment)[index - SegmentStart(segment)].load();
+  }
+
+  // Флаг и проверку соседей делаем seq_cst: два потока, закончившие соседние слоты,
+  // не могут оба не увидеть флаг друг друга, так что префикс не застрянет
+  void Publish(T* data, size_t segment, size_t index) {
+    Flags(data, segment)[index - SegmentStart(segment)].store(true);
+    size_t published = published_.load();
+    while (Ready(published)) {
+      if (published_.compare_exchange_weak(published, published + 1)) {
+        ++published;
+      }
+    }
+  }
+
+  T& Element(size_t index) const {
+    const size_t segment = SegmentOf(index);
+    T* data = segments_[segment].load(std::memory_order_acquire);
+    return data[index - SegmentStart(segment)];
+  }
+
+ public:
+  template <bool kConst>
+  class BasicIterator {
+   private:
+    const ConcurrentVector* owner_ = nullptr;
+    size_t index_ = 0;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;         // NOLINT
+    using value_type = T;                                        // NOLINT
+    using difference_type = std::ptrdiff_t;                      // NOLINT
+    using pointer = std::conditional_t<kConst, const T*, T*>;    // NOLINT
+    using reference = std::conditional_t<kConst, const T&, T&>;  // NOLINT
+
+    BasicIterator() = default;
+
+    BasicIterator(const ConcurrentVector* owner, size_t index) : owner_(owner), index_(index) {
+    }
+
+    reference operator*() const {
+      return owner_->Element(index_);
+    }
+
+    pointer operator->() const {
+      return &owner_->Element(index_);
+    }
+
+    BasicIterator& operator++() {
+      ++index_;
+      return *this;
+    }
+
+    BasicIterator operator++(int) {
+      BasicIterator copy = *this;
+      ++index_;
+      return copy;
+    }
+
+    bool operator==(const BasicIterator& other) const {
+      return index_ == other.index_;
+    }
+
+    bool operator!=(const BasicIterator& other) const {
+      return index_ != other.index_;
+    }
+  };
+
+  using ValueType = T;
+  using SizeType = size_t;
+  using Iterator = BasicIterator<false>;
+  using ConstIterator = BasicIterator<true>;
+
+  ConcurrentVector() = default;
+
+  ConcurrentVector(const ConcurrentVector&) = delete;
+  ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+  // Разрушать можно только когда добавления закончились; разрушаются только построенные слоты
+  ~ConcurrentVector() {
+    const size_t claimed = claimed_.load();
+    for (size_t segment = 0; segment < kMaxSegments; ++segment) {
+      T* data = segments_[segment].load();
+      if (!data) {
+        continue;
+      }
+      const size_t start = SegmentStart(segment);
+      if constexpr (!std::is_trivially_destructible_v<T>) {
+        const std::atomic<bool>* flags = Flags(data, segment);
+        for (size_t i = 0; start + i < claimed && i < SegmentSize(segment); ++i) {
+          if (flags[i].load(std::memory_order_relaxed)) {
+            data[i].~T();
+          }
+        }
+      }
+      ::operator delete(data);
+    }
+  }
+
+  // Заранее выделяет сегменты под capacity элементов, чтобы добавление не ходило в аллокатор
+  void Reserve(size_t capacity) {
+    for (size_t segment = 0; capacity > 0 && segment <= SegmentOf(capacity - 1); ++segment) {
+      EnsureSegment(segment);
+    }
+  }
+
+  // Возвращает индекс нового элемента; он виден читателям, как только опубликованы все предыдущие
+  template <typename... Args>
+  size_t EmplaceBack(Args&&... args) {
+    if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>) {
+      // Занятый слот нельзя вернуть, поэтому все, что может бросить, делаем до fetch_add
+      static_assert(std::is_nothrow_move_constructible_v<T>, "ConcurrentVector requires a nothrow move constructor");
+      return EmplaceBack(T(std::forward<Args>(args)...));
+    } else {
+      // Сегмент выделяется до захвата слота: если аллокация бросит, слот останется свободным.
+      // Если за это время слот забрал другой поток, CAS перечитает индекс и сегмент.
+      size_t index = claimed_.load(std::memory_order_relaxed);
+      size_t segment = 0;
+      T* data = nullptr;
+      do {
+        segment = SegmentOf(index);
+        data = EnsureSegment(segment);
+      } while (!claimed_.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+      new (data + index - SegmentStart(segment)) T(std::forward<Args>(args)...);
+      Publish(data, segment, index);
+      return index;
+    }
+  }
+
+  size_t PushBack(const T& value) {
+    return EmplaceBack(value);
+  }
+
+  size_t PushBack(T&& value) {
+    return EmplaceBack(std::move(value));
+  }
+
+  size_t Size() const {
+    return published_.load(std::memory_order_acquire);
+  }
+
+  bool Empty() const {
+    return Size() == 0;
+  }
+
+  // Без проверок и блокировок: индекс должен быть меньше уже прочитанного Size()
+  T& operator[](size_t index) {
+    return Element(index);
+  }
+
+  const T& operator[](size_t index) const {
+    return Element(index);
+  }
+
+  T& At(size_t index) {
+    if (index >= Size()) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return Element(index);
+  }
+
+  const T& At(size_t index) const {
+    if (index >= Size()) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return Element(index);
+  }
+
+  // Копия опубликованного префикса в обычный Vector, посегментно
+  Vector<T> Snapshot() const {
+    const size_t size = Size();
+    Vector<T> result;
+    result.Reserve(size);
+    for (size_t segment = 0; size > SegmentStart(segment); ++segment) {
+      const T* data = segments_[segment].load(std::memory_order_acquire);
+      const size_t count = std::min(size - SegmentStart(segment), SegmentSize(segment));
+      result.Append(data, data + count);
+    }
+    return result;
+  }
+
+  // end() фиксирует Size() на момент вызова
+  Iterator begin() {  // NOLINT
+    return {this, 0};
+  }
+
+  Iterator end() {  // NOLINT
+    return {this, Size()};
+  }
+
+  ConstIterator begin() const {  // NOLINT
+    return {this, 0};
+  }
+
+  ConstIterator end() const {  // NOLINT
+    return {this, Size()};
+  }
+};
+
+#endif  // CONCURRENT_VECTOR_HPP
@@ -0,0 +1,302 @@
+#ifndef PARALLEL_ALGORITHMS_HPP
+#define PARALLEL_ALGORITHMS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "vector.hpp"
+
+// Параллельные алгоритмы над непрерывными контейнерами с Data() и Size() (Vector, Array, ...).
+// Все они работают в общем ThreadPool::Instance(), если пул не передан явно.
+
+namespace parallel_detail {
+
+inline constexpr size_t kGrain = size_t{1} << 14;
+inline constexpr size_t kRadixBits = 8;
+inline constexpr size_t kRadixBuckets = size_t{1} << kRadixBits;
+
+// Ключ не шире 8 байт: long double и __int128 в uint64_t не помещаются и идут через сравнения
+template <class T>
+inline constexpr bool kRadixSortable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 8;
+
+template <class T>
+using RadixKey = std::conditional_t<sizeof(T) == 1, uint8_t,
+                                    std::conditional_t<sizeof(T) == 2, uint16_t,
+                                                       std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+// Переводит число в беззнаковый ключ с тем же порядком
+template <class T>
+RadixKey<T> ToRadixKey(T value) {
+  using Key = RadixKey<T>;
+  constexpr Key kSignBit = Key{1} << (sizeof(Key) * 8 - 1);
+  Key key = 0;
+  std::memcpy(&key, &value, sizeof(T));
+  if constexpr (std::is_floating_point_v<T>) {
+    return (key & kSignBit) ? static_cast<Key>(~key) : static_cast<Key>(key | kSignBit);
+  } else if constexpr (std::is_signed_v<T>) {
+    return key ^ kSignBit;
+  } else {
+    return key;
+  }
+}
+
+template <class T>
+void RadixSort(T* data, size_t size, ThreadPool& pool) {
+  Vector<T> buffer;
+  buffer.ResizeUninitialized(size);
+  T* src = data;
+  T* dst = buffer.Data();
+
+  const size_t chunks = ChunkCount(size, kGrain, pool);
+  std::vector<size_t> counts(chunks * kRadixBuckets);
+  for (size_t shift = 0; shift < sizeof(T) * 8; shift += kRadixBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    ParallelChunks(
+        size, kGrain,
+        [&](size_t chunk, size_t begin, size_t end) {
+          size_t* local = counts.data() + chunk * kRadixBuckets;
+          for (size_t i = begin; i < end; ++i) {
+            ++local[(ToRadixKey(src[i]) >> shift) & (kRadixBuckets - 1)];
+          }
+        },
+        pool);
+
+    // Если все ключи попали в одну корзину, проход ничего не меняет
+    bool trivial = false;
+    for (size_t bucket = 0; bucket < kRadixBuckets && !trivial; ++bucket) {
+      size_t total = 0;
+      for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        total += counts[chunk * kRadixBuckets + bucket];
+      }
+      trivial = total == size;
+    }
+    if (trivial) {
+      continue;
+    }
+
+    // Начало каждой корзины в каждом куске: сначала по корзинам, внутри корзины по кускам (стабильно)
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < kRadixBuckets; ++bucket) {
+      for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        const size_t count = counts[chunk * kRadixBuckets + bucket];
+        counts[chunk * kRadixBuckets + bucket] = offset;
+        offset += count;
+      }
+    }
+
+    ParallelChunks(
+        size, kGrain,
+        [&](size_t chunk, size_t begin, size_t end) {
+          size_t* local = counts.data() + chunk * kRadixBuckets;
+          for (size_t i = begin; i < end; ++i) {
+            dst[local[(ToRadixKey(src[i]) >> shift) & (kRadixBuckets - 1)]++] = src[i];
+          }
+        },
+        pool);
+    std::swap(src, dst);
+  }
+
+  if (src != data) {
+    ParallelChunks(
+        size, kGrain,
+        [&](size_t, size_t begin, size_t end) { std::memcpy(data + begin, src + begin, sizeof(T) * (end - begin)); },
+        pool);
+  }
+}
+
+// Сколько элементов первой последовательности попадает в первые k элементов слияния (merge path).
+// При равенстве первая последовательность идет раньше, поэтому слияние стабильно.
+template <class T, class Compare>
+size_t MergeSplit(const T* first, size_t first_size, const T* second, size_t second_size, size_t k,
+                  Compare& comp) {
+  size_t low = k > second_size ? k - second_size : 0;
+  size_t high = std::min(k, first_size);
+  while (low < high) {
+    const size_t i = low + (high - low) / 2;
+    if (comp(second[k - i - 1], first[i])) {
+      high = i;
+    } else {
+      low = i + 1;
+    }
+  }
+  return low;
+}
+
+template <class T, class Compare>
+void ParallelMerge(T* first, size_t first_size, T* second, size_t second_size, T* out, Compare& comp,
+                   ThreadPool& pool) {
+  const size_t total = first_size + second_size;
+  if (total == 0) {
+    return;
+  }
+  // Границы считаем заранее: во время слияния соседние куски уже перемещают элементы
+  const size_t chunks = ChunkCount(total, kGrain, pool);
+  std::vector<size_t> splits(chunks + 1);
+  for (size_t chunk = 0; chunk <= chunks; ++chunk) {
+    splits[chunk] = MergeSplit(first, first_size, second, second_size, total * chunk / chunks, comp);
+  }
+  ParallelChunks(
+      total, kGrain,
+      [&](size_t chunk, size_t begin, size_t end) {
+        const size_t i_begin = splits[chunk];
+        const size_t i_end = splits[chunk + 1];
+        std::merge(std::make_move_iterator(first + i_begin), std::make_move_iterator(first + i_end),
+                   std::make_move_iterator(second + (begin - i_begin)),
+                   std::make_move_iterator(second + (end - i_end)), out + begin, comp);
+      },
+      pool);
+}
+
+// Сортирует [data, data + size); результат остается в data, если to_data, иначе в buffer
+template <class T, class Compare>
+void MergeSort(T* data, T* buffer, size_t size, bool to_data, Compare& comp, ThreadPool& pool) {
+  if (size <= kGrain) {
+    std::stable_sort(data, data + size, comp);
+    if (!to_data) {
+      std::move(data, data + size, buffer);
+    }
+    return;
+  }
+  const size_t half = size / 2;
+  TaskGroup group(pool);
+  group.Run([&] { MergeSort(data, buffer, half, !to_data, comp, pool); });
+  MergeSort(data + half, buffer + half, size - half, !to_data, comp, pool);
+  group.Wait();
+
+  T* src = to_data ? buffer : data;
+  T* dst = to_data ? data : buffer;
+  ParallelMerge(src, half, src + half, size - half, dst, comp, pool);
+}
+
+}  // namespace parallel_detail
+
+// LSD-сортировка по байтам для целых и вещественных ключей; стабильна, O(n) на проход
+template <class Container>
+void ParallelRadixSort(Container& container, ThreadPool& pool = ThreadPool::Instance()) {
+  using T = std::remove_cv_t<std::remove_reference_t<decltype(*container.Data())>>;
+  static_assert(parallel_detail::kRadixSortable<T>, "ParallelRadixSort requires integer or floating point keys");
+  parallel_detail::RadixSort(container.Data(), container.Size(), pool);
+}
+
+// Стабильная сортировка слиянием для произвольного T, требует конструктор по умолчанию
+template <class Container, class Compare = std::less<>>
+void ParallelMergeSort(Container& container, Compare comp = Compare(), ThreadPool& pool = ThreadPool::Instance()) {
+  using T = std::remove_cv_t<std::remove_reference_t<decltype(*container.Data())>>;
+  Vector<T> buffer;
+  buffer.ResizeDefaultInit(container.Size());
+  parallel_detail::MergeSort(container.Data(), buffer.Data(), container.Size(), true, comp, pool);
+}
+
+template <class Container>
+void ParallelSort(Container& container, ThreadPool& pool = ThreadPool::Instance()) {
+  using T = std::remove_cv_t<std::remove_reference_t<decltype(*container.Data())>>;
+  if constexpr (parallel_detail::kRadixSortable<T>) {
+    ParallelRadixSort(container, pool);
+  } else {
+    ParallelMergeSort(container, std::less<>(), pool);
+  }
+}
+
+// out[i] = fn(in[i]); out должен быть не короче in, допускается out == in
+template <class Input, class Output, class F>
+void ParallelTransform(const Input& in, Output& out, F fn, ThreadPool& pool = ThreadPool::Instance()) {
+  const auto* src = in.Data();
+  auto* dst = out.Data();
+  ParallelChunks(
+      in.Size(), parallel_detail::kGrain,
+      [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          dst[i] = fn(src[i]);
+        }
+      },
+      pool);
+}
+
+// op должна быть ассоциативной: куски сворачиваются независимо, а потом по порядку
+template <class Container, class T, class Op = std::plus<>>
+T ParallelReduce(const Container& container, T init, Op op = Op(), ThreadPool& pool = ThreadPool::Instance()) {
+  const auto* data = container.Data();
+  std::vector<std::optional<T>> partial(ChunkCount(container.Size(), parallel_detail::kGrain, pool));
+  ParallelChunks(
+      container.Size(), parallel_detail::kGrain,
+      [&](size_t chunk, size_t begin, size_t end) {
+        T acc = data[begin];
+        for (size_t i = begin + 1; i < end; ++i) {
+          acc = op(std::move(acc), data[i]);
+        }
+        partial[chunk] = std::move(acc);
+      },
+      pool);
+  for (auto& value : partial) {
+    init = op(std::move(init), std::move(*value));
+  }
+  return init;
+}
+
+namespace parallel_detail {
+
+// Скан в три шага: свертка кусков, префикс по кускам, пересчет кусков со своим смещением
+template <class Input, class Output, class T, class Op>
+void Scan(const Input& in, Output& out, std::optional<T> init, bool inclusive, Op& op, ThreadPool& pool) {
+  const auto* src = in.Data();
+  auto* dst = out.Data();
+  const size_t size = in.Size();
+  std::vector<std::optional<T>> offsets(ChunkCount(size, kGrain, pool) + 1);
+  ParallelChunks(
+      size, kGrain,
+      [&](size_t chunk, size_t begin, size_t end) {
+        T acc = src[begin];
+        for (size_t i = begin + 1; i < end; ++i) {
+          acc = op(std::move(acc), src[i]);
+        }
+        offsets[chunk + 1] = std::move(acc);
+      },
+      pool);
+  offsets[0] = std::move(init);
+  for (size_t chunk = 1; chunk < offsets.size(); ++chunk) {
+    if (offsets[chunk - 1]) {
+      offsets[chunk] = op(*offsets[chunk - 1], std::move(*offsets[chunk]));
+    }
+  }
+  ParallelChunks(
+      size, kGrain,
+      [&](size_t chunk, size_t begin, size_t end) {
+        std::optional<T> acc = offsets[chunk];
+        for (size_t i = begin; i < end; ++i) {
+          T value = src[i];
+          if (!inclusive) {
+            dst[i] = *acc;
+          }
+          acc = acc ? op(std::move(*acc), std::move(value)) : std::move(value);
+          if (inclusive) {
+            dst[i] = *acc;
+          }
+        }
+      },
+      pool);
+}
+
+}  // namespace parallel_detail
+
+// out[i] = in[0] op ... op in[i]; допускается out == in
+template <class Input, class Output, class Op = std::plus<>>
+void ParallelInclusiveScan(const Input& in, Output& out, Op op = Op(), ThreadPool& pool = ThreadPool::Instance()) {
+  using T = std::remove_cv_t<std::remove_reference_t<decltype(*in.Data())>>;
+  parallel_detail::Scan(in, out, std::optional<T>(), true, op, pool);
+}
+
+// out[i] = init op in[0] op ... op in[i - 1]; допускается out == in
+template <class Input, class Output, class T, class Op = std::plus<>>
+void ParallelExclusiveScan(const Input& in, Output& out, T init, Op op = Op(),
+                           ThreadPool& pool = ThreadPool::Instance()) {
+  parallel_detail::Scan(in, out, std::optional<T>(std::move(init)), false, op, pool);
+}
+
+#endif  // PARALLEL_ALGORITHMS_HPP
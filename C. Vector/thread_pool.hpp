@@ -0,0 +1,227 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул с очередью на каждый поток: свои задачи поток берет с конца (LIFO, горячий кэш),
+// а когда своя очередь пуста, ворует у соседей с начала.
+class ThreadPool {
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<bool> stop_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+
+  static inline thread_local ThreadPool* current_pool_ = nullptr;
+  static inline thread_local size_t current_index_ = 0;
+
+  bool PopOwn(size_t index, std::function<void()>& task) {
+    Queue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool Steal(size_t thief, std::function<void()>& task) {
+    for (size_t shift = 1; shift <= queues_.size(); ++shift) {
+      Queue& queue = *queues_[(thief + shift) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool TakeTask(std::function<void()>& task) {
+    const bool own = current_pool_ == this;
+    const size_t index = own ? current_index_ : next_queue_.load(std::memory_order_relaxed) % queues_.size();
+    if ((own && PopOwn(index, task)) || Steal(index, task)) {
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void WorkerLoop(size_t index) {
+    current_pool_ = this;
+    current_index_ = index;
+    std::function<void()> task;
+    while (true) {
+      if (TakeTask(task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+      if (stop_) {
+        return;
+      }
+    }
+  }
+
+ public:
+  explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+      queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  static ThreadPool& Instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  size_t Size() const {
+    return workers_.size();
+  }
+
+  void Submit(std::function<void()> task) {
+    const size_t index =
+        current_pool_ == this ? current_index_ : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      queues_[index]->tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  // Выполняет одну задачу из пула в текущем потоке; так ожидающий поток помогает, а не простаивает
+  bool RunOne() {
+    std::function<void()> task;
+    if (!TakeTask(task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+};
+
+// Fork-join поверх пула: Run отдает задачу в пул, Wait дожидается всех и пробрасывает первое исключение
+class TaskGroup {
+ private:
+  ThreadPool& pool_;
+  std::atomic<size_t> pending_{0};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+
+ public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::Instance()) : pool_(pool) {
+  }
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  ~TaskGroup() {
+    while (pending_.load(std::memory_order_acquire) > 0) {
+      if (!pool_.RunOne()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  template <class F>
+  void Run(F task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.Submit([this, task = std::move(task)]() mutable {
+      try {
+        task();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      pending_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  void Wait() {
+    while (pending_.load(std::memory_order_acquire) > 0) {
+      if (!pool_.RunOne()) {
+        std::this_thread::yield();
+      }
+    }
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+};
+
+// Число кусков, на которое ParallelChunks разобьет size элементов
+inline size_t ChunkCount(size_t size, size_t grain, const ThreadPool& pool = ThreadPool::Instance()) {
+  if (size == 0) {
+    return 0;
+  }
+  grain = std::max<size_t>(grain, 1);
+  return std::clamp<size_t>((size + grain - 1) / grain, 1, pool.Size() * 4);
+}
+
+// Делит [0, size) на ChunkCount кусков и обрабатывает их в пуле: fn(chunk, begin, end)
+template <class F>
+void ParallelChunks(size_t size, size_t grain, F fn, ThreadPool& pool = ThreadPool::Instance()) {
+  const size_t chunks = ChunkCount(size, grain, pool);
+  if (chunks == 0) {
+    return;
+  }
+  if (chunks == 1) {
+    fn(size_t{0}, size_t{0}, size);
+    return;
+  }
+  TaskGroup group(pool);
+  for (size_t chunk = 1; chunk < chunks; ++chunk) {
+    group.Run([&fn, chunk, chunks, size] { fn(chunk, size * chunk / chunks, size * (chunk + 1) / chunks); });
+  }
+  fn(size_t{0}, size_t{0}, size / chunks);
+  group.Wait();
+}
+
+#endif  // THREAD_POOL_HPP
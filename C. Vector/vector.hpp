@@ -2,16 +2,523 @@
 #define VECTOR_HPP
 
 #define VECTOR_MEMORY_IMPLEMENTED
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// С -DVECTOR_INSTRUMENTATION каждый вектор запоминает место, где его создали, и копит по этому месту
+// статистику аллокаций и переездов; отчет печатается при выходе или по ReportVectorStats().
+// Без флага счетчики - пустые inline-функции, и Vector остается того же размера.
+#ifdef VECTOR_INSTRUMENTATION
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#define VECTOR_SITE std::source_location site = std::source_location::current()
+#define VECTOR_SITE_AFTER , VECTOR_SITE
+#define VECTOR_SITE_INIT , site_(site)
+#define VECTOR_SITE_FORWARD , site
+#else
+#define VECTOR_SITE
+#define VECTOR_SITE_AFTER
+#define VECTOR_SITE_INIT
+#define VECTOR_SITE_FORWARD
+#endif
+
+namespace vector_detail {
+
+// value-инициализация таких типов - это просто нули, поэтому хватает memset. Только скаляры:
+// в тривиальной структуре может лежать указатель на член, а его ноль в Itanium ABI - это -1
+template <class T>
+inline constexpr bool kZeroInitializable = std::is_arithmetic_v<T> || std::is_pointer_v<T> || std::is_enum_v<T>;
+
+// равенство таких типов совпадает с побайтовым, поэтому можно сравнивать через memcmp
+template <class T>
+inline constexpr bool kBitwiseComparable = std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+// memcmp сравнивает беззнаковые байты, так что для них он дает и лексикографический порядок
+template <class T>
+inline constexpr bool kByteComparable = kBitwiseComparable<T> && sizeof(T) == 1 && std::is_unsigned_v<T>;
+
+template <class T>
+void Destroy(T* data, size_t from, size_t to) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (size_t i = from; i < to; ++i) {
+      data[i].~T();
+    }
+  }
+}
+
+template <class T>
+void ValueConstruct(T* data, size_t from, size_t to) {
+  if constexpr (kZeroInitializable<T>) {
+    if (to > from) {
+      std::memset(static_cast<void*>(data + from), 0, sizeof(T) * (to - from));
+    }
+  } else if constexpr (std::is_nothrow_default_constructible_v<T>) {
+    for (size_t i = from; i < to; ++i) {
+      new (data + i) T();
+    }
+  } else {
+    size_t i = from;
+    try {
+      for (; i < to; ++i) {
+        new (data + i) T();
+      }
+    } catch (...) {
+      Destroy(data, from, i);
+      throw;
+    }
+  }
+}
+
+template <class T>
+void DefaultConstruct(T* data, size_t from, size_t to) {
+  if constexpr (!std::is_trivially_default_constructible_v<T>) {
+    size_t i = from;
+    try {
+      for (; i < to; ++i) {
+        new (data + i) T;
+      }
+    } catch (...) {
+      Destroy(data, from, i);
+      throw;
+    }
+  }
+}
+
+template <class T>
+void FillConstruct(T* data, size_t from, size_t to, const T& value) {
+  if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) == 1) {
+    if (to > from) {
+      unsigned char byte = 0;
+      std::memcpy(&byte, &value, 1);
+      std::memset(static_cast<void*>(data + from), byte, to - from);
+    }
+  } else if constexpr (std::is_trivially_copyable_v<T>) {
+    // локальная копия убирает алиасинг с data, и цикл векторизуется
+    const T fill = value;
+    for (size_t i = from; i < to; ++i) {
+      new (data + i) T(fill);
+    }
+  } else if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+    for (size_t i = from; i < to; ++i) {
+      new (data + i) T(value);
+    }
+  } else {
+    size_t i = from;
+    try {
+      for (; i < to; ++i) {
+        new (data + i) T(value);
+      }
+    } catch (...) {
+      Destroy(data, from, i);
+      throw;
+    }
+  }
+}
+
+template <class T>
+void CopyConstruct(T* dst, const T* src, size_t count) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (count > 0) {
+      std::memcpy(static_cast<void*>(dst), src, sizeof(T) * count);
+    }
+  } else if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+    for (size_t i = 0; i < count; ++i) {
+      new (dst + i) T(src[i]);
+    }
+  } else {
+    size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        new (dst + i) T(src[i]);
+      }
+    } catch (...) {
+      Destroy(dst, 0, i);
+      throw;
+    }
+  }
+}
+
+// Перенос при реаллокации: двигаем только если move не бросает, иначе копируем,
+// чтобы при исключении исходный буфер остался нетронутым (как std::move_if_noexcept)
+template <class T>
+void RelocateConstruct(T* dst, T* src, size_t count) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (count > 0) {
+      std::memcpy(static_cast<void*>(dst), src, sizeof(T) * count);
+    }
+  } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+    for (size_t i = 0; i < count; ++i) {
+      new (dst + i) T(std::move(src[i]));
+    }
+  } else {
+    size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        new (dst + i) T(std::move_if_noexcept(src[i]));
+      }
+    } catch (...) {
+      Destroy(dst, 0, i);
+      throw;
+    }
+  }
+}
+
+inline constexpr size_t kHugePageSize = size_t{2} << 20;
+
+inline size_t PageSize() {
+  static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+  return kPageSize;
+}
+
+inline size_t RoundUp(size_t bytes, size_t granularity) {
+  return (bytes + granularity - 1) / granularity * granularity;
+}
+
+// Резервирует bytes байт адресного пространства; физические страницы выделяются при первом касании
+inline void* MapPages(size_t bytes, bool huge_pages) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+  const size_t slack = huge_pages ? kHugePageSize : 0;
+  void* raw = mmap(nullptr, bytes + slack, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (raw == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  if (!huge_pages) {
+    return raw;
+  }
+  // Выравниваем начало по 2MB, иначе ядро не сможет отдать область большими страницами
+  char* begin = static_cast<char*>(raw);
+  char* aligned = begin + (kHugePageSize - reinterpret_cast<uintptr_t>(begin) % kHugePageSize) % kHugePageSize;
+  if (aligned > begin) {
+    munmap(begin, aligned - begin);
+  }
+  if (aligned + bytes < begin + bytes + slack) {
+    munmap(aligned + bytes, begin + slack - aligned);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+  return aligned;
+}
+
+#ifdef VECTOR_INSTRUMENTATION
+
+// Счетчики одного места создания; векторы с этого места могут жить в разных потоках
+struct SiteStats {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> allocated_bytes{0};
+  std::atomic<uint64_t> reallocations{0};
+  std::atomic<uint64_t> relocated_elements{0};
+  std::atomic<uint64_t> relocated_bytes{0};
+  std::atomic<uint64_t> peak_capacity{0};
+  std::atomic<uint64_t> released_buffers{0};
+  std::atomic<uint64_t> slack_bytes{0};
+};
+
+class SiteRegistry {
+ private:
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<SiteStats>> sites_;
+
+ public:
+  // Реестр намеренно не разрушается: глобальные векторы обновляют счетчики и после отчета при выходе
+  static SiteRegistry& Instance() {
+    static SiteRegistry* registry = [] {
+      auto* created = new SiteRegistry;
+      std::atexit([] { Instance().Report(std::cerr); });
+      return created;
+    }();
+    return *registry;
+  }
+
+  SiteStats& Get(const std::source_location& location) {
+    std::string key = std::string(location.file_name()) + ":" + std::to_string(location.line());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stats = sites_[std::move(key)];
+    if (!stats) {
+      stats = std::make_unique<SiteStats>();
+    }
+    return *stats;
+  }
+
+  // Сверху места, где больше всего байт переехало при росте - там в первую очередь не хватает Reserve
+  void Report(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<const std::string*, const SiteStats*>> rows;
+    for (const auto& [site, stats] : sites_) {
+      rows.emplace_back(&site, stats.get());
+    }
+    std::sort(rows.begin(), rows.end(), [](const auto& l, const auto& r) {
+      return l.second->relocated_bytes.load() > r.second->relocated_bytes.load();
+    });
+    out << "Vector stats by construction site:\n";
+    out << std::setw(12) << "allocs" << std::setw(16) << "alloc bytes" << std::setw(12) << "reallocs"
+        << std::setw(14) << "relocated" << std::setw(16) << "relocated bytes" << std::setw(14) << "peak cap"
+        << std::setw(12) << "released" << std::setw(16) << "slack bytes"
+        << "  site\n";
+    for (const auto& [site, stats] : rows) {
+      out << std::setw(12) << stats->allocations.load() << std::setw(16) << stats->allocated_bytes.load()
+          << std::setw(12) << stats->reallocations.load() << std::setw(14) << stats->relocated_elements.load()
+          << std::setw(16) << stats->relocated_bytes.load() << std::setw(14) << stats->peak_capacity.load()
+          << std::setw(12) << stats->released_buffers.load() << std::setw(16) << stats->slack_bytes.load() << "  "
+          << *site << "\n";
+    }
+  }
+};
+
+// Место создания вектора; счетчики ищутся в реестре при первом событии, так что векторы,
+// которые так и не выделили память, реестр не трогают
+class SiteHandle {
+ private:
+  std::source_location location_;
+  mutable SiteStats* stats_ = nullptr;
+
+  SiteStats& Stats() const {
+    if (!stats_) {
+      stats_ = &SiteRegistry::Instance().Get(location_);
+    }
+    return *stats_;
+  }
+
+ public:
+  explicit SiteHandle(std::source_location location = std::source_location::current()) : location_(location) {
+  }
+
+  void OnAllocate(size_t capacity, size_t bytes) const {
+    SiteStats& stats = Stats();
+    stats.allocations.fetch_add(1, std::memory_order_relaxed);
+    stats.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    uint64_t peak = stats.peak_capacity.load(std::memory_order_relaxed);
+    while (peak < capacity && !stats.peak_capacity.compare_exchange_weak(peak, capacity, std::memory_order_relaxed)) {
+    }
+  }
+
+  void OnRelocate(size_t count, size_t bytes) const {
+    if (count == 0) {
+      return;
+    }
+    SiteStats& stats = Stats();
+    stats.reallocations.fetch_add(1, std::memory_order_relaxed);
+    stats.relocated_elements.fetch_add(count, std::memory_order_relaxed);
+    stats.relocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Буфер освобождается окончательно: его незанятый хвост так и не пригодился
+  void OnRelease(size_t slack_bytes) const {
+    SiteStats& stats = Stats();
+    stats.released_buffers.fetch_add(1, std::memory_order_relaxed);
+    stats.slack_bytes.fetch_add(slack_bytes, std::memory_order_relaxed);
+  }
+};
+
+#else
+
+struct SiteHandle {
+  void OnAllocate(size_t, size_t) const {
+  }
+
+  void OnRelocate(size_t, size_t) const {
+  }
+
+  void OnRelease(size_t) const {
+  }
+};
+
+#endif
+
+}  // namespace vector_detail
+
+// Печатает статистику по местам создания векторов; без VECTOR_INSTRUMENTATION ничего не делает
+inline void ReportVectorStats(std::ostream& out = std::cerr) {
+#ifdef VECTOR_INSTRUMENTATION
+  vector_detail::SiteRegistry::Instance().Report(out);
+#else
+  (void)out;
+#endif
+}
 
 template <class T>
 class Vector {
 
  private:
   T* vec_ = nullptr;
+  // Два старших бита - режим хранения (mmap и huge pages), остальные - емкость. Такой емкости не
+  // бывает (Allocate ее не выделит), зато Vector остается в три слова, а move и Swap переносят
+  // режим вместе с буфером.
   size_t capacity_ = 0;
   size_t size_ = 0;
+  // Место создания переезжает вместе с буфером (move, Swap), копия получает свое
+  [[no_unique_address]] vector_detail::SiteHandle site_;
+
+  static constexpr size_t kMappedBit = size_t{1} << (std::numeric_limits<size_t>::digits - 1);
+  static constexpr size_t kHugePagesBit = kMappedBit >> 1;
+  static constexpr size_t kModeBits = kMappedBit | kHugePagesBit;
+
+  bool HugePages() const {
+    return capacity_ & kHugePagesBit;
+  }
+
+  void SetCapacity(size_t capacity) {
+    capacity_ = (capacity_ & kModeBits) | capacity;
+  }
+
+  size_t MappedBytes(size_t capacity) const {
+    return vector_detail::RoundUp(sizeof(T) * capacity,
+                                  HugePages() ? vector_detail::kHugePageSize : vector_detail::PageSize());
+  }
+
+  // В mmap-режиме емкость округляется вверх до целых страниц
+  T* Allocate(size_t& capacity) const {
+    if (capacity & kModeBits) {
+      throw std::length_error("Vector capacity is too large");
+    }
+    if (!Mapped()) {
+      T* data = static_cast<T*>(::operator new(sizeof(T) * capacity));
+      site_.OnAllocate(capacity, sizeof(T) * capacity);
+      return data;
+    }
+    const size_t bytes = MappedBytes(capacity);
+    capacity = bytes / sizeof(T);
+    T* data = static_cast<T*>(vector_detail::MapPages(bytes, HugePages()));
+    site_.OnAllocate(capacity, bytes);
+    return data;
+  }
+
+  void Deallocate(T* data, size_t capacity) const {
+    if (!data) {
+      return;
+    }
+    if (Mapped()) {
+      munmap(data, MappedBytes(capacity));
+    } else {
+      ::operator delete(data);
+    }
+  }
+
+  // Окончательно отдает буфер, элементы уже разрушены; size_ еще старый, так что незанятый хвост
+  // попадает в статистику места создания
+  void ReleaseBuffer() {
+    if (vec_) {
+      site_.OnRelease(sizeof(T) * (Capacity() - size_));
+    }
+    Deallocate(vec_, Capacity());
+  }
+
+  // Отдает ядру целые страницы за последним живым элементом, резерв адресов остается
+  void ReleaseUnusedPages() {
+    const uintptr_t page = HugePages() ? vector_detail::kHugePageSize : vector_detail::PageSize();
+    const uintptr_t from = vector_detail::RoundUp(reinterpret_cast<uintptr_t>(vec_ + size_), page);
+    const uintptr_t to = reinterpret_cast<uintptr_t>(vec_) + MappedBytes(Capacity());
+    if (from < to) {
+      madvise(reinterpret_cast<void*>(from), to - from, MADV_DONTNEED);
+    }
+  }
+
+  template <class Construct>
+  void ResizeWith(size_t new_size, Construct construct) {
+    if (new_size > Capacity()) {
+      Reallocate(new_size, size_, new_size - size_, [&](T* data) { construct(data, size_, new_size); });
+    } else if (new_size > size_) {
+      construct(vec_, size_, new_size);
+      size_ = new_size;
+    } else if (new_size < size_) {
+      vector_detail::Destroy(vec_, new_size, size_);
+      size_ = new_size;
+    }
+  }
+
+  size_t GrowCapacity(size_t min_capacity) const {
+    return std::max(Capacity() * 2, min_capacity);
+  }
+
+  // Единственный путь роста: сначала строим новые элементы [pos, pos + count) в новом буфере,
+  // пока старый еще цел (аргументы могут ссылаться на элементы самого вектора), потом переносим
+  // старые по обе стороны от дырки. Если перенос бросил, старый буфер не тронут - строгая гарантия.
+  template <class Construct>
+  void Reallocate(size_t new_capacity, size_t pos, size_t count, Construct construct) {
+    T* new_vec = Allocate(new_capacity);
+    try {
+      construct(new_vec);
+    } catch (...) {
+      Deallocate(new_vec, new_capacity);
+      throw;
+    }
+    site_.OnRelocate(size_, sizeof(T) * size_);
+    try {
+      vector_detail::RelocateConstruct(new_vec, vec_, pos);
+      try {
+        vector_detail::RelocateConstruct(new_vec + pos + count, vec_ + pos, size_ - pos);
+      } catch (...) {
+        vector_detail::Destroy(new_vec, 0, pos);
+        throw;
+      }
+    } catch (...) {
+      vector_detail::Destroy(new_vec, pos, pos + count);
+      Deallocate(new_vec, new_capacity);
+      throw;
+    }
+    vector_detail::Destroy(vec_, 0, size_);
+    Deallocate(vec_, Capacity());
+
+    vec_ = new_vec;
+    SetCapacity(new_capacity);
+    size_ += count;
+  }
+
+  // Лежит ли хоть один элемент [first, last) внутри вектора. Для непрерывных диапазонов хватает
+  // концов; остальные (например, v.rbegin(), v.rend()) проверяются поэлементно, но только для
+  // тривиальных T: InsertInPlace для прочих строит новые элементы до сдвига хвоста.
+  template <class Iter>
+  bool Overlaps(Iter first, Iter last, size_t count) const {
+    if constexpr (std::contiguous_iterator<Iter>) {
+      const T* from = std::to_address(first);
+      return from < vec_ + size_ && from + count > vec_;
+    } else if constexpr (std::is_trivially_copyable_v<T> &&
+                         std::is_lvalue_reference_v<typename std::iterator_traits<Iter>::reference>) {
+      return std::any_of(first, last, [this](const auto& item) {
+        const void* address = std::addressof(item);
+        return std::less<const void*>()(address, vec_ + size_) && !std::less<const void*>()(address, vec_);
+      });
+    } else {
+      return false;
+    }
+  }
+
+  // Вставка без реаллокации: для тривиально перемещаемых типов сдвигаем хвост memmove и строим
+  // элементы в дырке, для остальных строим их в конце и поворачиваем на место.
+  template <class Construct>
+  void InsertInPlace(size_t pos, size_t count, Construct construct) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memmove(static_cast<void*>(vec_ + pos + count), vec_ + pos, sizeof(T) * (size_ - pos));
+      construct(vec_ + pos);
+      size_ += count;
+    } else {
+      construct(vec_ + size_);
+      size_ += count;
+      std::rotate(vec_ + pos, vec_ + size_ - count, vec_ + size_);
+    }
+  }
 
  public:
   using ValueType = T;
@@ -25,65 +532,47 @@ class Vector {
   using ReverseIterator = std::reverse_iterator<Iterator>;
   using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
 
-  Vector() : vec_(nullptr), capacity_(0), size_(0) {
+  Vector(VECTOR_SITE) : vec_(nullptr), capacity_(0), size_(0) VECTOR_SITE_INIT {
   }
 
-  explicit Vector(size_t number) : vec_(nullptr), capacity_(0), size_(0) {
+  explicit Vector(size_t number VECTOR_SITE_AFTER) : vec_(nullptr), capacity_(0), size_(0) VECTOR_SITE_INIT {
     if (number > 0) {
-      vec_ = static_cast<T*>(::operator new(sizeof(T) * number));
-      capacity_ = number;
-      size_ = number;
-
-      size_t i = 0;
+      vec_ = Allocate(number);
       try {
-        for (; i < size_; ++i) {
-          new (&vec_[i]) T();
-        }
+        vector_detail::ValueConstruct(vec_, 0, number);
       } catch (...) {
-        // Уничтожаем созданные объекты
-        for (size_t j = 0; j < i; ++j) {
-          vec_[j].~T();
-        }
-        ::operator delete(vec_);
+        Deallocate(vec_, number);
         vec_ = nullptr;
-        capacity_ = 0;
-        size_ = 0;
         throw;
       }
+      capacity_ = number;
+      size_ = number;
     }
   }
 
-  explicit Vector(size_t size, const T& value) : vec_(nullptr), capacity_(0), size_(0) {
+  explicit Vector(size_t size, const T& value VECTOR_SITE_AFTER)
+      : vec_(nullptr), capacity_(0), size_(0) VECTOR_SITE_INIT {
     if (size > 0) {
-      vec_ = static_cast<T*>(::operator new(sizeof(T) * size));
-      capacity_ = size;
-      size_ = size;
-
-      size_t i = 0;
+      vec_ = Allocate(size);
       try {
-        for (; i < size_; ++i) {
-          new (&vec_[i]) T(value);
-        }
+        vector_detail::FillConstruct(vec_, 0, size, value);
       } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          vec_[j].~T();
-        }
-        ::operator delete(vec_);
+        Deallocate(vec_, size);
         vec_ = nullptr;
-        capacity_ = 0;
-        size_ = 0;
         throw;
       }
+      capacity_ = size;
+      size_ = size;
     }
   }
 
   template <class Iterator, class = std::enable_if_t<std::is_base_of_v<
                                 std::forward_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>>>
-  Vector(Iterator begin, Iterator end) : vec_(nullptr), capacity_(0), size_(0) {
+  Vector(Iterator begin, Iterator end VECTOR_SITE_AFTER) : vec_(nullptr), capacity_(0), size_(0) VECTOR_SITE_INIT {
     size_ = std::distance(begin, end);
     if (size_ > 0) {
       capacity_ = size_;
-      vec_ = static_cast<T*>(::operator new(sizeof(T) * capacity_));
+      vec_ = Allocate(capacity_);
 
       size_t i = 0;
       try {
@@ -94,7 +583,7 @@ class Vector {
         for (size_t j = 0; j < i; ++j) {
           vec_[j].~T();
         }
-        ::operator delete(vec_);
+        Deallocate(vec_, Capacity());
         vec_ = nullptr;
         capacity_ = 0;
         size_ = 0;
@@ -103,33 +592,30 @@ class Vector {
     }
   }
 
-  Vector(std::initializer_list<T> init) : Vector(init.begin(), init.end()) {
+  Vector(std::initializer_list<T> init VECTOR_SITE_AFTER) : Vector(init.begin(), init.end() VECTOR_SITE_FORWARD) {
   }
 
-  Vector(const Vector& other) : vec_(nullptr), capacity_(0), size_(0) {
+  Vector(const Vector& other VECTOR_SITE_AFTER) : vec_(nullptr), capacity_(0), size_(0) VECTOR_SITE_INIT {
     if (other.size_ > 0) {
-      capacity_ = other.size_;
-      vec_ = static_cast<T*>(::operator new(sizeof(T) * capacity_));
-
-      size_t i = 0;
+      size_t capacity = other.size_;
+      vec_ = Allocate(capacity);
       try {
-        for (; i < other.size_; ++i) {
-          new (vec_ + i) T(other.vec_[i]);
-        }
-        size_ = other.size_;
+        vector_detail::CopyConstruct(vec_, other.vec_, other.size_);
       } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          vec_[j].~T();
-        }
-        ::operator delete(vec_);
+        Deallocate(vec_, capacity);
         vec_ = nullptr;
-        capacity_ = 0;
         throw;
       }
+      capacity_ = capacity;
+      size_ = other.size_;
     }
   }
 
-  Vector(Vector&& other) noexcept : vec_(other.vec_), capacity_(other.capacity_), size_(other.size_) {
+  Vector(Vector&& other) noexcept
+      : vec_(other.vec_)
+      , capacity_(other.capacity_)
+      , size_(other.size_)
+      , site_(other.site_) {
     other.vec_ = nullptr;
     other.capacity_ = 0;
     other.size_ = 0;
@@ -137,12 +623,13 @@ class Vector {
 
   Vector& operator=(Vector&& other) noexcept {
     if (this != &other) {
-      Clear();
-      ::operator delete(vec_);
+      DeleteTrash(vec_, 0, size_);
+      ReleaseBuffer();
 
       vec_ = other.vec_;
       capacity_ = other.capacity_;
       size_ = other.size_;
+      site_ = other.site_;
 
       other.vec_ = nullptr;
       other.capacity_ = 0;
@@ -151,19 +638,19 @@ class Vector {
     return *this;
   }
 
+  // Новый буфер строится во временном векторе с нашим местом создания, чтобы Swap его не потерял
   Vector& operator=(const Vector& second_vector) {
-    Vector temp(second_vector);
+    Vector temp;
+    temp.site_ = site_;
+    temp.Reserve(second_vector.size_);
+    temp.Append(second_vector.begin(), second_vector.end());
     Swap(temp);
     return *this;
   }
 
   ~Vector() noexcept {
-    for (size_t i = 0; i < size_; ++i) {
-      vec_[i].~T();
-    }
-    if (vec_) {
-      ::operator delete(vec_);
-    }
+    vector_detail::Destroy(vec_, 0, size_);
+    ReleaseBuffer();
   }
 
   size_t Size() const {
@@ -171,7 +658,7 @@ class Vector {
   }
 
   size_t Capacity() const {
-    return capacity_;
+    return capacity_ & ~kModeBits;
   }
 
   bool Empty() const {
@@ -206,233 +693,87 @@ class Vector {
     std::swap(vec_, second_vector.vec_);
     std::swap(capacity_, second_vector.capacity_);
     std::swap(size_, second_vector.size_);
+    std::swap(site_, second_vector.site_);
   }
 
   void DeleteTrash(T* start, size_t from, size_t to) {
-    for (size_t i = from; i < to; ++i) {
-      start[i].~T();
-    }
+    vector_detail::Destroy(start, from, to);
   }
 
-  T* ReallocateD(size_t new_capacity, size_t new_size) {
-    T* new_vec = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-    size_t i = 0;
-    try {
-      for (; i < size_; ++i) {
-        new (new_vec + i) T(static_cast<T&&>(vec_[i]));
-      }
-      for (; i < new_size; ++i) {
-        new (new_vec + i) T();
-      }
-    } catch (...) {
-      DeleteTrash(new_vec, 0, i);
-      ::operator delete(new_vec);
-      throw;
-    }
-    return new_vec;
+  void Resize(size_t new_size) {
+    ResizeWith(new_size, [](T* data, size_t from, size_t to) { vector_detail::ValueConstruct(data, from, to); });
   }
 
-  T* ReallocateV(size_t new_capacity, size_t new_size, const T& value) {
-    T* new_vec = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-    size_t i = 0;
-    try {
-      for (; i < size_; ++i) {
-        new (new_vec + i) T(static_cast<T&&>(vec_[i]));
-      }
-      for (; i < new_size; ++i) {
-        new (new_vec + i) T(value);
-      }
-    } catch (...) {
-      DeleteTrash(new_vec, 0, i);
-      ::operator delete(new_vec);
-      throw;
-    }
-    return new_vec;
+  void Resize(size_t new_size, const T& value) {
+    ResizeWith(new_size,
+               [&](T* data, size_t from, size_t to) { vector_detail::FillConstruct(data, from, to, value); });
   }
 
-  void Resize(size_t new_size) {
-    if (new_size > size_) {
-      if (new_size > capacity_) {
-        T* new_vec = ReallocateD(new_size, new_size);
-
-        DeleteTrash(vec_, 0, size_);
-        ::operator delete(vec_);
-
-        vec_ = new_vec;
-        capacity_ = new_size;
-      } else {
-        size_t i = size_;
-        try {
-          for (; i < new_size; ++i) {
-            new (vec_ + i) T();
-          }
-        } catch (...) {
-          DeleteTrash(vec_, size_, i);
-          throw;
-        }
-      }
-      size_ = new_size;
-    } else if (new_size < size_) {
-      DeleteTrash(vec_, new_size, size_);
-      size_ = new_size;
-    }
+  // Новые элементы default-инициализируются: для классов вызывается конструктор по умолчанию,
+  // а память тривиальных типов не трогается вовсе
+  void ResizeDefaultInit(size_t new_size) {
+    ResizeWith(new_size, [](T* data, size_t from, size_t to) { vector_detail::DefaultConstruct(data, from, to); });
   }
 
-  void Resize(size_t new_size, const T& value) {
-    if (new_size > size_) {
-      if (new_size > capacity_) {
-        T* new_vec = ReallocateV(new_size, new_size, value);
-
-        DeleteTrash(vec_, 0, size_);
-        ::operator delete(vec_);
-
-        vec_ = new_vec;
-        capacity_ = new_size;
-      } else {
-        size_t i = size_;
-        try {
-          for (; i < new_size; ++i) {
-            new (vec_ + i) T(value);
-          }
-        } catch (...) {
-          DeleteTrash(vec_, size_, i);
-          throw;
-        }
-      }
-      size_ = new_size;
-    } else if (new_size < size_) {
-      DeleteTrash(vec_, new_size, size_);
-      size_ = new_size;
-    }
+  // Для буферов, которые сразу перезапишутся (read из файла или сокета): новые элементы не инициализируются
+  void ResizeUninitialized(size_t new_size) {
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                  "ResizeUninitialized requires a trivially constructible type");
+    ResizeDefaultInit(new_size);
   }
 
   void Reserve(size_t new_capacity) {
-    if (new_capacity <= capacity_) {
-      return;
-    }
-    T* new_vec = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-    size_t i = 0;
-    try {
-      for (; i < size_; ++i) {
-        new (new_vec + i) T(std::move(vec_[i]));
-      }
-    } catch (...) {
-      for (size_t j = 0; j < i; ++j) {
-        new_vec[j].~T();
-      }
-      ::operator delete(new_vec);
-      throw;
+    if (new_capacity > Capacity()) {
+      Reallocate(new_capacity, size_, 0, [](T*) {});
     }
+  }
 
-    for (size_t j = 0; j < size_; ++j) {
-      vec_[j].~T();
-    }
-    ::operator delete(vec_);
+  // Переводит вектор в mmap-режим: резервирует адресное пространство под capacity элементов,
+  // и дальнейший рост в его пределах не двигает элементы. huge_pages просит у ядра страницы по 2MB.
+  void ReserveMapped(size_t capacity, bool huge_pages = false) {
+    Vector mapped;
+    mapped.site_ = site_;
+    mapped.capacity_ = kMappedBit | (huge_pages ? kHugePagesBit : 0);
+    mapped.Reserve(std::max<size_t>({capacity, size_, 1}));
+    vector_detail::RelocateConstruct(mapped.vec_, vec_, size_);
+    mapped.size_ = size_;
+    Swap(mapped);
+  }
 
-    vec_ = new_vec;
-    capacity_ = new_capacity;
+  bool Mapped() const {
+    return capacity_ & kMappedBit;
   }
 
   void ShrinkToFit() {
+    if (Mapped()) {
+      ReleaseUnusedPages();
+      return;
+    }
     if (size_ == 0) {
-      ::operator delete(vec_);
+      ReleaseBuffer();
       vec_ = nullptr;
-      capacity_ = 0;
+      SetCapacity(0);
       return;
     }
-    if (capacity_ > size_) {
-      T* new_vec = static_cast<T*>(::operator new(sizeof(T) * size_));
-      size_t i = 0;
-      try {
-        for (; i < size_; ++i) {
-          new (new_vec + i) T(std::move(vec_[i]));
-        }
-      } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          new_vec[j].~T();
-        }
-        ::operator delete(new_vec);
-        throw;
-      }
-
-      for (size_t j = 0; j < size_; ++j) {
-        vec_[j].~T();
-      }
-      ::operator delete(vec_);
-
-      vec_ = new_vec;
-      capacity_ = size_;
+    if (Capacity() > size_) {
+      Reallocate(size_, size_, 0, [](T*) {});
     }
   }
 
   void Clear() {
-    for (size_t i = 0; i < size_; ++i) {
-      vec_[i].~T();
-    }
+    DeleteTrash(vec_, 0, size_);
     size_ = 0;
+    if (Mapped()) {
+      ReleaseUnusedPages();
+    }
   }
 
   void PushBack(const T& value) {
-    if (size_ == capacity_) {
-      size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-      T* new_vec = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-      size_t i = 0;
-      try {
-        for (; i < size_; ++i) {
-          new (new_vec + i) T(std::move(vec_[i]));
-        }
-        new (new_vec + size_) T(value);
-      } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          new_vec[j].~T();
-        }
-        ::operator delete(new_vec);
-        throw;
-      }
-      for (size_t i = 0; i < size_; ++i) {
-        vec_[i].~T();
-      }
-      ::operator delete(vec_);
-
-      vec_ = new_vec;
-      capacity_ = new_capacity;
-      ++size_;
-    } else {
-      new (vec_ + size_) T(value);
-      ++size_;
-    }
+    EmplaceBack(value);
   }
 
   void PushBack(T&& value) {
-    if (size_ == capacity_) {
-      size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-      T* new_vec = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-
-      size_t i = 0;
-      try {
-        for (; i < size_; ++i) {
-          new (new_vec + i) T(std::move(vec_[i]));
-        }
-        new (new_vec + size_) T(std::move(value));
-      } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          new_vec[j].~T();
-        }
-        ::operator delete(new_vec);
-        throw;
-      }
-      for (size_t i = 0; i < size_; ++i) {
-        vec_[i].~T();
-      }
-      ::operator delete(vec_);
-
-      vec_ = new_vec;
-      capacity_ = new_capacity;
-      ++size_;
-    } else {
-      new (vec_ + size_) T(std::move(value));
-      ++size_;
-    }
+    EmplaceBack(std::move(value));
   }
 
   void PopBack() {
@@ -466,37 +807,112 @@ class Vector {
 
   template <typename... Args>
   void EmplaceBack(Args&&... args) {
-    if (size_ == capacity_) {
-      size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-      T* new_data = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
-
-      size_t i = 0;
-      try {
-        for (; i < size_; ++i) {
-          new (new_data + i) T(std::move(vec_[i]));
-        }
-        new (new_data + size_) T(std::forward<Args>(args)...);
-      } catch (...) {
-        for (size_t j = 0; j < i; ++j) {
-          new_data[j].~T();
-        }
-        ::operator delete(new_data);
-        throw;
-      }
-
-      for (size_t i = 0; i < size_; ++i) {
-        vec_[i].~T();
-      }
-      ::operator delete(vec_);
-      vec_ = new_data;
-      capacity_ = new_capacity;
-      ++size_;
+    if (size_ == Capacity()) {
+      Reallocate(GrowCapacity(size_ + 1), size_, 1,
+                 [&](T* data) { new (data + size_) T(std::forward<Args>(args)...); });
     } else {
       new (vec_ + size_) T(std::forward<Args>(args)...);
       ++size_;
     }
   }
 
+  template <typename... Args>
+  Iterator EmplaceAt(ConstIterator pos, Args&&... args) {
+    const size_t index = pos - vec_;
+    if (size_ == Capacity()) {
+      Reallocate(GrowCapacity(size_ + 1), index, 1,
+                 [&](T* data) { new (data + index) T(std::forward<Args>(args)...); });
+    } else if (index == size_) {
+      new (vec_ + size_) T(std::forward<Args>(args)...);
+      ++size_;
+    } else {
+      // args могут ссылаться на сдвигаемые элементы, поэтому сначала строим значение
+      T value(std::forward<Args>(args)...);
+      InsertInPlace(index, 1, [&](T* data) { new (data) T(std::move(value)); });
+    }
+    return vec_ + index;
+  }
+
+  Iterator Insert(ConstIterator pos, const T& value) {
+    return EmplaceAt(pos, value);
+  }
+
+  Iterator Insert(ConstIterator pos, T&& value) {
+    return EmplaceAt(pos, std::move(value));
+  }
+
+  // [first, last) может быть куском самого вектора (v.Append(v.begin(), v.end())): такой кусок
+  // сначала копируется, потому что сдвиг на месте затер бы его раньше, чем он будет прочитан
+  template <class Iter, class = std::enable_if_t<std::is_base_of_v<
+                            std::forward_iterator_tag, typename std::iterator_traits<Iter>::iterator_category>>>
+  Iterator Insert(ConstIterator pos, Iter first, Iter last) {
+    const size_t index = pos - vec_;
+    const size_t count = std::distance(first, last);
+    if (count == 0) {
+      return vec_ + index;
+    }
+    if (size_ + count <= Capacity() && Overlaps(first, last, count)) {
+      const Vector copy(first, last);
+      return Insert(pos, copy.begin(), copy.end());
+    }
+    auto construct = [&](T* data) { std::uninitialized_copy_n(first, count, data); };
+    if (size_ + count > Capacity()) {
+      Reallocate(GrowCapacity(size_ + count), index, count, [&](T* data) { construct(data + index); });
+    } else {
+      InsertInPlace(index, count, construct);
+    }
+    return vec_ + index;
+  }
+
+  template <class Iter, class = std::enable_if_t<std::is_base_of_v<
+                            std::forward_iterator_tag, typename std::iterator_traits<Iter>::iterator_category>>>
+  void Append(Iter first, Iter last) {
+    Insert(cend(), first, last);
+  }
+
+  template <class Iter, class = std::enable_if_t<std::is_base_of_v<
+                            std::forward_iterator_tag, typename std::iterator_traits<Iter>::iterator_category>>>
+  void AssignRange(Iter first, Iter last) {
+    const size_t count = std::distance(first, last);
+    if (count > Capacity()) {
+      Vector temp;
+      temp.site_ = site_;
+      temp.Reserve(count);
+      temp.Append(first, last);
+      Swap(temp);
+      return;
+    }
+    const size_t common = std::min(count, size_);
+    Iter middle = std::next(first, common);
+    std::copy(first, middle, vec_);
+    if (count > size_) {
+      std::uninitialized_copy(middle, last, vec_ + size_);
+    } else {
+      DeleteTrash(vec_, count, size_);
+    }
+    size_ = count;
+  }
+
+  Iterator Erase(ConstIterator first, ConstIterator last) {
+    const size_t from = first - vec_;
+    const size_t count = last - first;
+    if (count == 0) {
+      return vec_ + from;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memmove(static_cast<void*>(vec_ + from), vec_ + from + count, sizeof(T) * (size_ - from - count));
+    } else {
+      std::move(vec_ + from + count, vec_ + size_, vec_ + from);
+    }
+    DeleteTrash(vec_, size_ - count, size_);
+    size_ -= count;
+    return vec_ + from;
+  }
+
+  Iterator Erase(ConstIterator pos) {
+    return Erase(pos, pos + 1);
+  }
+
   Iterator begin() {  // NOLINT
     return vec_;
   }
@@ -546,18 +962,19 @@ class Vector {
   }
 
   friend bool operator==(const Vector& l, const Vector& r) {
-    bool flag = true;
     if (r.size_ != l.size_) {
-      flag = false;
+      return false;
+    }
+    if constexpr (vector_detail::kBitwiseComparable<T>) {
+      return l.size_ == 0 || std::memcmp(l.vec_, r.vec_, sizeof(T) * l.size_) == 0;
     } else {
       for (size_t i = 0; i < l.size_; ++i) {
         if (l.vec_[i] != r.vec_[i]) {
-          flag = false;
-          break;
+          return false;
         }
       }
+      return true;
     }
-    return flag;
   }
 
   friend bool operator!=(const Vector& l, const Vector& r) {
@@ -565,24 +982,20 @@ class Vector {
   }
 
   friend bool operator<(const Vector& l, const Vector& r) {
-    size_t size = 0;
-    if (r.size_ > l.size_) {
-      size = l.size_;
-    } else {
-      size = r.size_;
-    }
-
-    if (l.size_ < r.size_) {
-      size = l.size_;
-    } else {
-      size = r.size_;
-    }
-    for (size_t i = 0; i < size; ++i) {
-      if (l.vec_[i] > r.vec_[i]) {
-        return false;
+    const size_t size = std::min(l.size_, r.size_);
+    if constexpr (vector_detail::kByteComparable<T>) {
+      const int cmp = size == 0 ? 0 : std::memcmp(l.vec_, r.vec_, size);
+      if (cmp != 0) {
+        return cmp < 0;
       }
-      if (l.vec_[i] < r.vec_[i]) {
-        return true;
+    } else {
+      for (size_t i = 0; i < size; ++i) {
+        if (l.vec_[i] > r.vec_[i]) {
+          return false;
+        }
+        if (l.vec_[i] < r.vec_[i]) {
+          return true;
+        }
       }
     }
     return l.size_ < r.size_;
@@ -0,0 +1,86 @@
+#include "vector.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+
+// Заполнение Vector<char> из файла: Resize(n) сначала зануляет весь буфер, ResizeUninitialized - нет.
+// Размер в мегабайтах можно передать первым аргументом, по умолчанию 1GB.
+
+namespace {
+
+const char* const kPath = "vector_benchmark.bin";
+
+void ReadAll(int fd, char* data, size_t size) {
+  lseek(fd, 0, SEEK_SET);
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t got = read(fd, data + done, size - done);
+    if (got <= 0) {
+      std::perror("read");
+      std::exit(1);
+    }
+    done += got;
+  }
+}
+
+template <class Fill>
+double Measure(size_t size, int fd, Fill fill) {
+  const auto start = std::chrono::steady_clock::now();
+  Vector<char> buffer;
+  fill(buffer, size);
+  ReadAll(fd, buffer.Data(), size);
+  const auto finish = std::chrono::steady_clock::now();
+  if (buffer[size - 1] != static_cast<char>((size - 1) % 251)) {
+    std::cerr << "unexpected content\n";
+    std::exit(1);
+  }
+  return std::chrono::duration<double>(finish - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 1024;
+  const size_t size = megabytes << 20;
+
+  {
+    Vector<char> pattern;
+    pattern.ResizeUninitialized(size);
+    for (size_t i = 0; i < size; ++i) {
+      pattern[i] = static_cast<char>(i % 251);
+    }
+    FILE* file = std::fopen(kPath, "wb");
+    if (!file || std::fwrite(pattern.Data(), 1, size, file) != size) {
+      std::perror("write");
+      return 1;
+    }
+    std::fclose(file);
+  }
+
+  const int fd = open(kPath, O_RDONLY);
+  if (fd < 0) {
+    std::perror("open");
+    return 1;
+  }
+
+  const int rounds = 3;
+  double resize = 0;
+  double uninitialized = 0;
+  for (int i = 0; i < rounds; ++i) {
+    resize += Measure(size, fd, [](Vector<char>& buffer, size_t n) { buffer.Resize(n); });
+    uninitialized += Measure(size, fd, [](Vector<char>& buffer, size_t n) { buffer.ResizeUninitialized(n); });
+  }
+  close(fd);
+  std::remove(kPath);
+
+  const double gigabytes = static_cast<double>(size) / (1 << 30);
+  std::cout << "size: " << megabytes << " MB, rounds: " << rounds << "\n";
+  std::cout << "Resize + read:              " << resize / rounds << " s, " << gigabytes * rounds / resize
+            << " GB/s\n";
+  std::cout << "ResizeUninitialized + read: " << uninitialized / rounds << " s, "
+            << gigabytes * rounds / uninitialized << " GB/s\n";
+}
@@ -0,0 +1,511 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_vector.hpp"
+#include "parallel_algorithms.hpp"
+#include "vector.hpp"
+#include "vector.hpp"  // check include guards
+#include "vector_serialization.hpp"
+
+namespace {
+
+struct WithMemberPointer {
+  int value;
+  int WithMemberPointer::*member;
+};
+
+enum class Color : uint8_t { kRed, kGreen };
+
+// Копия бросает, когда счетчик разрешенных копий дошел до нуля; move бросающий, если kNothrowMove = false
+template <bool kNothrowMove>
+struct Fragile {
+  inline static int copies_left = 1 << 30;
+  inline static int alive = 0;
+  int value = 0;
+
+  explicit Fragile(int v) : value(v) {
+    ++alive;
+  }
+
+  Fragile(const Fragile& other) : value(other.value) {
+    if (copies_left-- <= 0) {
+      throw std::runtime_error("copy");
+    }
+    ++alive;
+  }
+
+  Fragile(Fragile&& other) noexcept(kNothrowMove) : value(other.value) {
+    other.value = -1;
+    ++alive;
+  }
+
+  Fragile& operator=(const Fragile&) = default;
+
+  ~Fragile() {
+    --alive;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Value Initialization", "[Vector]") {
+  const Vector<int> ints(17);
+  REQUIRE(ints.Size() == 17);
+  for (int x : ints) {
+    REQUIRE(x == 0);
+  }
+
+  const Vector<double*> pointers(5);
+  REQUIRE(pointers[4] == nullptr);
+
+  const Vector<Color> colors(3);
+  REQUIRE(colors[2] == Color::kRed);
+
+  // нулевой указатель на член - не нулевые байты, поэтому такие структуры не обнуляются memset
+  const Vector<WithMemberPointer> structs(4);
+  for (const auto& s : structs) {
+    REQUIRE(s.value == 0);
+    REQUIRE(s.member == nullptr);
+  }
+
+  Vector<std::string> strings(2);
+  strings.Resize(6);
+  REQUIRE(strings[5].empty());
+}
+
+TEST_CASE("Trivial Fast Paths", "[Vector]") {
+  Vector<char> bytes(100, 'x');
+  REQUIRE(bytes[99] == 'x');
+  Vector<int> ints(33, 7);
+  const Vector<int> copy(ints);
+  REQUIRE(copy == ints);
+  ints[32] = 8;
+  REQUIRE(copy != ints);
+  REQUIRE(copy < ints);
+
+  const Vector<unsigned char> a{1, 2, 3};
+  const Vector<unsigned char> b{1, 2, 200};
+  const Vector<unsigned char> prefix{1, 2};
+  REQUIRE(a < b);
+  REQUIRE(prefix < a);
+  REQUIRE_FALSE(b < a);
+}
+
+TEST_CASE("Strong Guarantee On Growth", "[Vector]") {
+  using Copyable = Fragile<false>;
+  {
+    Vector<Copyable> v;
+    for (int i = 0; i < 4; ++i) {
+      v.EmplaceBack(i);
+    }
+    v.ShrinkToFit();
+    // move может бросить, поэтому при росте элементы копируются, а третья копия падает
+    Copyable::copies_left = 2;
+    REQUIRE_THROWS_AS(v.EmplaceBack(4), std::runtime_error);
+    Copyable::copies_left = 1 << 30;
+    REQUIRE(v.Size() == 4);
+    REQUIRE(v.Capacity() == 4);
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(v[i].value == i);
+    }
+
+    Copyable::copies_left = 0;
+    REQUIRE_THROWS_AS(v.Reserve(100), std::runtime_error);
+    REQUIRE_THROWS_AS(Vector<Copyable>(v), std::runtime_error);
+    Copyable::copies_left = 1 << 30;
+    REQUIRE(v.Capacity() == 4);
+    REQUIRE(v[3].value == 3);
+  }
+  REQUIRE(Copyable::alive == 0);
+
+  using Movable = Fragile<true>;
+  {
+    Vector<Movable> v;
+    v.EmplaceBack(1);
+    v.ShrinkToFit();
+    // noexcept move: рост не копирует вовсе, так что запрет копий не мешает
+    Movable::copies_left = 0;
+    v.EmplaceBack(2);
+    v.Reserve(64);
+    Movable::copies_left = 1 << 30;
+    REQUIRE(v.Size() == 2);
+    REQUIRE(v[0].value == 1);
+    REQUIRE(v[1].value == 2);
+  }
+  REQUIRE(Movable::alive == 0);
+}
+
+TEST_CASE("Push Back Own Element", "[Vector]") {
+  Vector<std::string> v{"first"};
+  for (int i = 0; i < 10; ++i) {
+    v.ShrinkToFit();
+    v.PushBack(v[0]);
+  }
+  REQUIRE(v.Size() == 11);
+  REQUIRE(v.Back() == "first");
+
+  v.ShrinkToFit();
+  v.Resize(20, v[0]);
+  REQUIRE(v[19] == "first");
+}
+
+TEST_CASE("Insert And Erase", "[Vector]") {
+  Vector<int> v{1, 2, 5};
+  v.Insert(v.begin() + 2, 4);
+  v.Insert(v.begin() + 2, 3);
+  v.EmplaceAt(v.begin(), 0);
+  REQUIRE(v == Vector<int>{0, 1, 2, 3, 4, 5});
+
+  const std::vector<int> tail{6, 7, 8};
+  v.Append(tail.begin(), tail.end());
+  v.Erase(v.begin() + 1, v.begin() + 3);
+  v.Erase(v.begin());
+  REQUIRE(v == Vector<int>{3, 4, 5, 6, 7, 8});
+
+  v.AssignRange(tail.begin(), tail.end());
+  REQUIRE(v == Vector<int>{6, 7, 8});
+
+  Vector<std::string> strings{"a", "d"};
+  const std::vector<std::string> middle{"b", "c"};
+  strings.Insert(strings.begin() + 1, middle.begin(), middle.end());
+  strings.Erase(strings.begin());
+  REQUIRE(strings == Vector<std::string>{"b", "c", "d"});
+}
+
+TEST_CASE("Self Aliasing Insert", "[Vector]") {
+  Vector<int> v{1, 2, 3};
+  v.Reserve(100);
+  v.Append(v.begin(), v.end());
+  REQUIRE(v == Vector<int>{1, 2, 3, 1, 2, 3});
+  v.Insert(v.begin() + 1, v.Back());
+  REQUIRE(v == Vector<int>{1, 3, 2, 3, 1, 2, 3});
+
+  // кусок лежит правее места вставки, и сдвиг хвоста накрыл бы его
+  Vector<int> w{1, 2, 3, 4, 5};
+  w.Reserve(100);
+  w.Insert(w.begin() + 1, w.begin() + 3, w.end());
+  REQUIRE(w == Vector<int>{1, 4, 5, 2, 3, 4, 5});
+
+  // непрерывности нет, но элементы те же самые
+  Vector<int> r{1, 2, 3, 4};
+  r.Reserve(100);
+  r.Insert(r.begin(), r.rbegin(), r.rend());
+  REQUIRE(r == Vector<int>{4, 3, 2, 1, 1, 2, 3, 4});
+  r.Insert(r.begin() + 2, r.rbegin() + 1, r.rbegin() + 3);
+  REQUIRE(r == Vector<int>{4, 3, 3, 2, 2, 1, 1, 2, 3, 4});
+
+  // без запаса емкости тот же кусок читается из старого буфера при росте
+  Vector<int> full{4, 5};
+  full.ShrinkToFit();
+  full.Append(full.begin(), full.end());
+  REQUIRE(full == Vector<int>{4, 5, 4, 5});
+
+  Vector<std::string> strings{"x", "y"};
+  strings.Reserve(10);
+  strings.Insert(strings.begin(), strings.begin(), strings.end());
+  strings.EmplaceAt(strings.begin() + 1, strings[3]);
+  REQUIRE(strings == Vector<std::string>{"x", "y", "y", "x", "y"});
+}
+
+TEST_CASE("Mapped Storage", "[Vector]") {
+  Vector<int> v{1, 2, 3};
+  v.ReserveMapped(1 << 20);
+  REQUIRE(v.Mapped());
+  REQUIRE(v.Capacity() >= (1 << 20));
+  REQUIRE(v == Vector<int>{1, 2, 3});
+
+  // рост в пределах резерва не двигает элементы
+  const int* data = v.Data();
+  for (int i = 3; i < 100000; ++i) {
+    v.PushBack(i + 1);
+  }
+  REQUIRE(v.Data() == data);
+  REQUIRE(v[99999] == 100000);
+
+  v.Resize(10);
+  v.ShrinkToFit();
+  REQUIRE(v.Data() == data);
+  REQUIRE(v[9] == 10);
+
+  Vector<int> moved(std::move(v));
+  REQUIRE(moved.Mapped());
+  REQUIRE(!v.Mapped());
+  REQUIRE(moved.Data() == data);
+  const Vector<int> copy(moved);
+  REQUIRE(copy == moved);
+  REQUIRE(!copy.Mapped());
+
+  Vector<int> heap{7};
+  heap.Swap(moved);
+  REQUIRE(heap.Mapped());
+  REQUIRE(!moved.Mapped());
+  REQUIRE(moved.Capacity() >= 1);
+  REQUIRE(heap.Capacity() >= (1 << 20));
+  moved = std::move(heap);
+  REQUIRE(moved.Mapped());
+  REQUIRE(moved.Data() == data);
+
+  Vector<std::string> strings{"a", "b"};
+  strings.ReserveMapped(1000, true);
+  strings.EmplaceBack("c");
+  REQUIRE(strings == Vector<std::string>{"a", "b", "c"});
+  strings.Clear();
+  REQUIRE(strings.Empty());
+  REQUIRE(strings.Capacity() >= 1000);
+
+#ifndef VECTOR_INSTRUMENTATION
+  // Режим хранения не раздувает вектор
+  static_assert(sizeof(Vector<int>) == 3 * sizeof(void*));
+#endif
+}
+
+TEST_CASE("Uninitialized Resize", "[Vector]") {
+  Vector<int> v{1, 2};
+  v.ResizeUninitialized(1000);
+  REQUIRE(v.Size() == 1000);
+  REQUIRE(v[0] == 1);
+  REQUIRE(v[1] == 2);
+  for (size_t i = 2; i < v.Size(); ++i) {
+    v[i] = static_cast<int>(i);
+  }
+  v.ResizeUninitialized(3);
+  REQUIRE(v == Vector<int>{1, 2, 2});
+
+  Vector<std::string> strings{"x"};
+  strings.ResizeDefaultInit(3);
+  REQUIRE(strings.Size() == 3);
+  REQUIRE(strings[0] == "x");
+  REQUIRE(strings[2].empty());
+}
+
+TEST_CASE("Parallel Sort", "[Vector]") {
+  ThreadPool pool(4);
+  std::mt19937 gen(42);
+  const size_t size = 100000;
+
+  Vector<int> ints(size);
+  for (auto& x : ints) {
+    x = static_cast<int>(gen());
+  }
+  std::vector<int> expected(ints.begin(), ints.end());
+  std::sort(expected.begin(), expected.end());
+  ParallelSort(ints, pool);
+  REQUIRE(std::equal(ints.begin(), ints.end(), expected.begin(), expected.end()));
+
+  Vector<double> doubles(size);
+  for (auto& x : doubles) {
+    x = std::uniform_real_distribution<double>(-1e6, 1e6)(gen);
+  }
+  ParallelSort(doubles, pool);
+  REQUIRE(std::is_sorted(doubles.begin(), doubles.end()));
+
+  // 16-байтный long double не влезает в ключ поразрядной сортировки и идет через слияние
+  Vector<long double> longs(size);
+  for (auto& x : longs) {
+    x = std::uniform_real_distribution<long double>(-1e6, 1e6)(gen);
+  }
+  ParallelSort(longs, pool);
+  REQUIRE(std::is_sorted(longs.begin(), longs.end()));
+
+  Vector<std::string> strings;
+  for (int i = 0; i < 50000; ++i) {
+    strings.PushBack(std::to_string(gen() % 1000));
+  }
+  std::vector<std::string> sorted(strings.begin(), strings.end());
+  std::stable_sort(sorted.begin(), sorted.end());
+  ParallelMergeSort(strings, std::less<>(), pool);
+  REQUIRE(std::equal(strings.begin(), strings.end(), sorted.begin(), sorted.end()));
+
+  Vector<int> empty;
+  ParallelSort(empty, pool);
+  REQUIRE(empty.Empty());
+}
+
+TEST_CASE("Parallel Reduce And Scan", "[Vector]") {
+  ThreadPool pool(4);
+  Vector<int64_t> values(100003);
+  for (size_t i = 0; i < values.Size(); ++i) {
+    values[i] = static_cast<int64_t>(i % 17) - 8;
+  }
+  int64_t total = 0;
+  for (auto x : values) {
+    total += x;
+  }
+  REQUIRE(ParallelReduce(values, int64_t{5}, std::plus<>(), pool) == total + 5);
+
+  Vector<int64_t> inclusive(values.Size());
+  ParallelInclusiveScan(values, inclusive, std::plus<>(), pool);
+  Vector<int64_t> exclusive(values.Size());
+  ParallelExclusiveScan(values, exclusive, int64_t{1}, std::plus<>(), pool);
+  int64_t acc = 0;
+  for (size_t i = 0; i < values.Size(); ++i) {
+    REQUIRE(exclusive[i] == acc + 1);
+    acc += values[i];
+    REQUIRE(inclusive[i] == acc);
+  }
+
+  ParallelTransform(values, values, [](int64_t x) { return x * 2; }, pool);
+  REQUIRE(values[16] == 16);
+
+  ParallelInclusiveScan(values, values, std::plus<>(), pool);
+  REQUIRE(values.Back() == 2 * total);
+}
+
+TEST_CASE("Concurrent Append", "[Vector]") {
+  const int threads = 4;
+  const int per_thread = 20000;
+  {
+    ConcurrentVector<std::string> v;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+      writers.emplace_back([&v, t] {
+        for (int i = 0; i < per_thread; ++i) {
+          v.PushBack(std::to_string(t * per_thread + i));
+        }
+      });
+    }
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    REQUIRE(v.Size() == threads * per_thread);
+    std::vector<int> seen;
+    for (const auto& s : v) {
+      seen.push_back(std::stoi(s));
+    }
+    std::sort(seen.begin(), seen.end());
+    for (int i = 0; i < threads * per_thread; ++i) {
+      REQUIRE(seen[i] == i);
+    }
+    REQUIRE(v.Snapshot().Size() == v.Size());
+  }
+
+  // Конструктор бросил до захвата слота: размер не меняется, следующие добавления публикуются
+  ConcurrentVector<Fragile<true>> fragile;
+  fragile.EmplaceBack(1);
+  Fragile<true> source(2);
+  Fragile<true>::copies_left = 0;
+  REQUIRE_THROWS_AS(fragile.PushBack(source), std::runtime_error);
+  Fragile<true>::copies_left = 1 << 30;
+  fragile.PushBack(source);
+  REQUIRE(fragile.Size() == 2);
+  REQUIRE(fragile.At(1).value == 2);
+  REQUIRE_THROWS_AS(fragile.At(2), std::out_of_range);
+}
+
+TEST_CASE("Serialization", "[Vector]") {
+  const std::string path = "vector_public_test.bin";
+  Vector<double> values(1000);
+  for (size_t i = 0; i < values.Size(); ++i) {
+    values[i] = static_cast<double>(i) / 3;
+  }
+  SaveVector(path, values);
+  REQUIRE(LoadVector<double>(path) == values);
+  {
+    const VectorView<double> view(path);
+    REQUIRE(view.Size() == values.Size());
+    REQUIRE(std::equal(view.begin(), view.end(), values.begin()));
+  }
+  REQUIRE_THROWS_AS(LoadVector<int>(path), VectorSerializationError);
+
+  SaveVector(path, Vector<int>());
+  REQUIRE(LoadVector<int>(path).Empty());
+
+  // Заголовок обещает больше элементов, чем есть в файле, или столько, что байты не влезают в size_t
+  for (uint64_t count : {uint64_t{1001}, uint64_t{1} << 62, ~uint64_t{0}}) {
+    VectorFileHeader header;
+    header.element_size = sizeof(double);
+    header.element_align = alignof(double);
+    header.count = count;
+    {
+      std::ofstream out(path, std::ios::binary);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char*>(values.Data()), sizeof(double) * values.Size());
+    }
+    REQUIRE_THROWS_AS(LoadVector<double>(path), VectorSerializationError);
+    REQUIRE_THROWS_AS(VectorView<double>(path), VectorSerializationError);
+  }
+
+  // Из трубы размер файла неизвестен: короткие данные дают ошибку, а не огромную аллокацию
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  VectorFileHeader header;
+  header.element_size = sizeof(int);
+  header.element_align = alignof(int);
+  header.count = uint64_t{1} << 40;
+  REQUIRE(write(fds[1], &header, sizeof(header)) == sizeof(header));
+  close(fds[1]);
+  REQUIRE_THROWS_AS(ReadVector<int>(fds[0]), VectorSerializationError);
+  close(fds[0]);
+
+  // Целые данные из трубы: несколько кусков, и емкость в итоге ровно под count
+  Vector<int> streamed(3 * (1 << 18) + 5);
+  for (size_t i = 0; i < streamed.Size(); ++i) {
+    streamed[i] = static_cast<int>(i * 7);
+  }
+  REQUIRE(pipe(fds) == 0);
+  std::thread writer([&] {
+    WriteVector(fds[1], streamed);
+    close(fds[1]);
+  });
+  const Vector<int> loaded = ReadVector<int>(fds[0]);
+  writer.join();
+  close(fds[0]);
+  REQUIRE(loaded == streamed);
+  REQUIRE(loaded.Capacity() == loaded.Size());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Instrumentation", "[Vector]") {
+  std::ostringstream report;
+  {
+    Vector<int> v;
+    for (int i = 0; i < 100; ++i) {
+      v.PushBack(i);
+    }
+    ReportVectorStats(report);
+  }
+#ifdef VECTOR_INSTRUMENTATION
+  REQUIRE(report.str().find("vector_public_test.cpp") != std::string::npos);
+
+  // ShrinkToFit пустого вектора освобождает буфер, и весь он уходит в slack
+  const std::string site = "vector_public_test.cpp:" + std::to_string(__LINE__ + 1);
+  Vector<int> shrunk;
+  shrunk.Reserve(100);
+  shrunk.ShrinkToFit();
+  REQUIRE(shrunk.Capacity() == 0);
+  std::ostringstream after;
+  ReportVectorStats(after);
+  std::istringstream lines(after.str());
+  std::string line;
+  bool found = false;
+  while (std::getline(lines, line)) {
+    if (line.size() >= site.size() && line.compare(line.size() - site.size(), site.size(), site) == 0) {
+      std::istringstream fields(line);
+      uint64_t values[8];
+      for (auto& value : values) {
+        fields >> value;
+      }
+      REQUIRE(values[6] == 1);
+      REQUIRE(values[7] == 100 * sizeof(int));
+      found = true;
+    }
+  }
+  REQUIRE(found);
+#else
+  // без флага место создания не хранится, и отчет пуст
+  REQUIRE(report.str().empty());
+  REQUIRE(sizeof(Vector<int>) <= 4 * sizeof(size_t));
+#endif
+}
@@ -0,0 +1,304 @@
+#ifndef VECTOR_SERIALIZATION_HPP
+#define VECTOR_SERIALIZATION_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "vector.hpp"
+
+// Бинарный снимок Vector<T> для тривиально копируемых T: 64-байтный заголовок и сразу за ним
+// элементы в порядке байтов текущей машины. Заголовок кратен 64, так что в отображенном файле
+// данные выровнены и их можно читать на месте.
+
+class VectorSerializationError : public std::runtime_error {
+ public:
+  explicit VectorSerializationError(const std::string& what) : std::runtime_error("VectorSerializationError: " + what) {
+  }
+};
+
+struct VectorFileHeader {
+  static constexpr uint32_t kMagic = 0x43455642;  // "BVEC"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic = kMagic;
+  uint32_t version = kVersion;
+  uint64_t element_size = 0;
+  uint64_t element_align = 0;
+  uint64_t count = 0;
+  unsigned char reserved[32] = {};
+};
+
+static_assert(sizeof(VectorFileHeader) == 64);
+
+namespace serialization_detail {
+
+[[noreturn]] inline void Fail(const std::string& what) {
+  throw VectorSerializationError(what + ": " + std::strerror(errno));
+}
+
+template <class T>
+void CheckHeader(const VectorFileHeader& header) {
+  if (header.magic != VectorFileHeader::kMagic || header.version != VectorFileHeader::kVersion) {
+    throw VectorSerializationError("not a vector snapshot");
+  }
+  if (header.element_size != sizeof(T) || header.element_align != alignof(T)) {
+    throw VectorSerializationError("element type mismatch");
+  }
+}
+
+inline void ReadExact(int fd, void* data, size_t size) {
+  auto* out = static_cast<unsigned char*>(data);
+  while (size > 0) {
+    const ssize_t got = read(fd, out, size);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got < 0) {
+      Fail("read");
+    }
+    if (got == 0) {
+      throw VectorSerializationError("unexpected end of file");
+    }
+    out += got;
+    size -= got;
+  }
+}
+
+// Сколько байт обычного файла осталось после текущей позиции; у труб и сокетов размера нет
+inline std::optional<uint64_t> RemainingBytes(int fd) {
+  struct stat info {};
+  if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode)) {
+    return std::nullopt;
+  }
+  const off_t position = lseek(fd, 0, SEEK_CUR);
+  if (position < 0 || position > info.st_size) {
+    return std::nullopt;
+  }
+  return static_cast<uint64_t>(info.st_size - position);
+}
+
+class FileDescriptor {
+ private:
+  int fd_ = -1;
+
+ public:
+  FileDescriptor(const std::string& path, int flags) : fd_(open(path.c_str(), flags, 0644)) {
+    if (fd_ < 0) {
+      Fail("open " + path);
+    }
+  }
+
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  ~FileDescriptor() {
+    close(fd_);
+  }
+
+  int Get() const {
+    return fd_;
+  }
+};
+
+}  // namespace serialization_detail
+
+// Заголовок и данные уходят одним writev (дописываем, только если ядро записало не все)
+template <class T>
+void WriteVector(int fd, const Vector<T>& vec) {
+  static_assert(std::is_trivially_copyable_v<T>, "WriteVector requires a trivially copyable type");
+  VectorFileHeader header;
+  header.element_size = sizeof(T);
+  header.element_align = alignof(T);
+  header.count = vec.Size();
+
+  iovec parts[2] = {{&header, sizeof(header)}, {const_cast<T*>(vec.Data()), sizeof(T) * vec.Size()}};
+  iovec* part = parts;
+  int left = vec.Empty() ? 1 : 2;
+  while (left > 0) {
+    const ssize_t written = writev(fd, part, left);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written < 0) {
+      serialization_detail::Fail("writev");
+    }
+    size_t done = written;
+    while (left > 0 && done >= part->iov_len) {
+      done -= part->iov_len;
+      ++part;
+      --left;
+    }
+    if (left > 0) {
+      part->iov_base = static_cast<char*>(part->iov_base) + done;
+      part->iov_len -= done;
+    }
+  }
+}
+
+template <class T>
+void SaveVector(const std::string& path, const Vector<T>& vec) {
+  serialization_detail::FileDescriptor file(path, O_WRONLY | O_CREAT | O_TRUNC);
+  WriteVector(file.Get(), vec);
+}
+
+// Владеющий Vector: для обычного файла одна аллокация под все элементы и чтение прямо в нее.
+// count из заголовка не доверяем: для файла он сверяется с остатком, а из трубы читаем кусками и
+// растим емкость вдвое (но не дальше count), так что испорченный заголовок не заставит выделить
+// память под данные, которых нет, а перенос элементов в сумме остается линейным.
+template <class T>
+Vector<T> ReadVector(int fd) {
+  static_assert(std::is_trivially_copyable_v<T>, "ReadVector requires a trivially copyable type");
+  constexpr size_t kStreamChunk = (size_t{1} << 20) / sizeof(T) + 1;
+  VectorFileHeader header;
+  serialization_detail::ReadExact(fd, &header, sizeof(header));
+  serialization_detail::CheckHeader<T>(header);
+  if (header.count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+    throw VectorSerializationError("element count is too large");
+  }
+  const size_t count = header.count;
+  const std::optional<uint64_t> remaining = serialization_detail::RemainingBytes(fd);
+  if (remaining && *remaining / sizeof(T) < count) {
+    throw VectorSerializationError("file is too short");
+  }
+  Vector<T> result;
+  if (remaining) {
+    result.ResizeDefaultInit(count);
+    serialization_detail::ReadExact(fd, result.Data(), sizeof(T) * count);
+    return result;
+  }
+  while (result.Size() < count) {
+    const size_t done = result.Size();
+    const size_t next = done + std::min(count - done, kStreamChunk);
+    result.Reserve(std::min(count, std::max(2 * result.Capacity(), next)));
+    result.ResizeDefaultInit(next);
+    serialization_detail::ReadExact(fd, result.Data() + done, sizeof(T) * (result.Size() - done));
+  }
+  return result;
+}
+
+template <class T>
+Vector<T> LoadVector(const std::string& path) {
+  serialization_detail::FileDescriptor file(path, O_RDONLY);
+  return ReadVector<T>(file.Get());
+}
+
+// Только для чтения: элементы остаются в отображенном файле, ничего не копируется
+template <class T>
+class VectorView {
+ private:
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const T* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  using ValueType = T;
+  using ConstIterator = const T*;
+
+  VectorView() = default;
+
+  explicit VectorView(const std::string& path) {
+    static_assert(std::is_trivially_copyable_v<T>, "VectorView requires a trivially copyable type");
+    static_assert(alignof(T) <= sizeof(VectorFileHeader), "element alignment exceeds the header size");
+    serialization_detail::FileDescriptor file(path, O_RDONLY);
+    struct stat info {};
+    if (fstat(file.Get(), &info) < 0) {
+      serialization_detail::Fail("fstat " + path);
+    }
+    const size_t file_size = info.st_size;
+    if (file_size < sizeof(VectorFileHeader)) {
+      throw VectorSerializationError("file is too short");
+    }
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file.Get(), 0);
+    if (mapping == MAP_FAILED) {
+      serialization_detail::Fail("mmap " + path);
+    }
+    mapping_ = mapping;
+    mapping_size_ = file_size;
+
+    VectorFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    try {
+      serialization_detail::CheckHeader<T>(header);
+      if ((file_size - sizeof(header)) / sizeof(T) < header.count) {
+        throw VectorSerializationError("file is too short");
+      }
+    } catch (...) {
+      munmap(mapping_, mapping_size_);
+      throw;
+    }
+    data_ = reinterpret_cast<const T*>(static_cast<const unsigned char*>(mapping) + sizeof(header));
+    size_ = header.count;
+  }
+
+  VectorView(const VectorView&) = delete;
+  VectorView& operator=(const VectorView&) = delete;
+
+  VectorView(VectorView&& other) noexcept
+      : mapping_(std::exchange(other.mapping_, nullptr))
+      , mapping_size_(std::exchange(other.mapping_size_, 0))
+      , data_(std::exchange(other.data_, nullptr))
+      , size_(std::exchange(other.size_, 0)) {
+  }
+
+  VectorView& operator=(VectorView&& other) noexcept {
+    VectorView temp(std::move(other));
+    std::swap(mapping_, temp.mapping_);
+    std::swap(mapping_size_, temp.mapping_size_);
+    std::swap(data_, temp.data_);
+    std::swap(size_, temp.size_);
+    return *this;
+  }
+
+  ~VectorView() {
+    if (mapping_) {
+      munmap(mapping_, mapping_size_);
+    }
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  bool Empty() const {
+    return size_ == 0;
+  }
+
+  const T* Data() const {
+    return data_;
+  }
+
+  const T& operator[](size_t ind) const {
+    return data_[ind];
+  }
+
+  const T& At(size_t ind) const {
+    if (ind >= size_) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return data_[ind];
+  }
+
+  ConstIterator begin() const {  // NOLINT
+    return data_;
+  }
+
+  ConstIterator end() const {  // NOLINT
+    return data_ + size_;
+  }
+};
+
+#endif  // VECTOR_SERIALIZATION_HPP
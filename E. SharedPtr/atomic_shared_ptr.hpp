@@ -0,0 +1,192 @@
+#ifndef ATOMIC_SHARED_PTR_H
+#define ATOMIC_SHARED_PTR_H
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "shared_ptr.hpp"
+
+// Атомарная ячейка с SharedPtr без блокировок (раздельные счетчики). Значение лежит в узле, а в
+// атомарном слове - указатель на узел и 16-битный внешний счетчик читателей, которые сейчас
+// копируют из узла. Читатель увеличивает внешний счетчик, копирует SharedPtr и возвращает счетчик
+// назад. Если узел успели заменить, возврат идет во внутренний счетчик узла, а писатель при
+// замене переносит туда накопленный внешний. Узел удаляет тот, кто свел сумму к нулю.
+// Писатель никого не ждет, читатель ждет только при 65535 одновременных чтениях.
+// Указатель на узел должен помещаться в 48 бит. На x86-64 и AArch64 с 4-уровневыми таблицами страниц
+// это так, а с 5-уровневыми (LA57) куча может оказаться выше: MakeWord это проверяет и бросает.
+template <typename T>
+class AtomicSharedPtr {
+ private:
+  using Value = SharedPtr<T, AtomicPolicy>;
+
+  struct Node {
+    Value value;
+    std::atomic<int64_t> internal_count{0};
+
+    explicit Node(Value&& v) : value(std::move(v)) {
+    }
+  };
+
+  static_assert(sizeof(void*) == 8, "AtomicSharedPtr packs a 48-bit pointer and a 16-bit counter");
+
+  static constexpr int kCountShift = 48;
+  static constexpr uint64_t kOne = uint64_t{1} << kCountShift;
+  static constexpr uint64_t kPointerMask = kOne - 1;
+  static constexpr uint64_t kMaxCount = (uint64_t{1} << (64 - kCountShift)) - 1;
+
+  std::atomic<uint64_t> word_{0};
+
+  static Node* NodeOf(uint64_t word) {
+    return reinterpret_cast<Node*>(word & kPointerMask);
+  }
+
+  static int64_t CountOf(uint64_t word) {
+    return static_cast<int64_t>(word >> kCountShift);
+  }
+
+  static uint64_t MakeWord(Value&& value) {
+    if (!value) {
+      return 0;
+    }
+    Node* node = new Node(std::move(value));
+    const auto word = reinterpret_cast<uint64_t>(node);
+    if (word & ~kPointerMask) {
+      delete node;
+      throw std::length_error("AtomicSharedPtr: node address does not fit in 48 bits");
+    }
+    return word;
+  }
+
+  // Захватывает текущий узел: увеличивает внешний счетчик, возвращает слово уже с ним
+  uint64_t Acquire() {
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    while (true) {
+      if (!NodeOf(word)) {
+        return word;
+      }
+      if (CountOf(word) == static_cast<int64_t>(kMaxCount)) {
+        std::this_thread::yield();
+        word = word_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (word_.compare_exchange_weak(word, word + kOne, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return word + kOne;
+      }
+    }
+  }
+
+  // Отпускает захваченный узел: пока он еще в слове, возвращаем единицу во внешний счетчик
+  void Release(Node* node) {
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    while (NodeOf(word) == node) {
+      if (word_.compare_exchange_weak(word, word - kOne, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    if (node->internal_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete node;
+    }
+  }
+
+  // Узел вынут из слова вместе с external захватами; drop из них принадлежат вызывающему
+  static void Retire(uint64_t word, int64_t drop = 0) {
+    Node* node = NodeOf(word);
+    if (!node) {
+      return;
+    }
+    const int64_t transfer = CountOf(word) - drop;
+    if (node->internal_count.fetch_add(transfer, std::memory_order_acq_rel) == -transfer) {
+      delete node;
+    }
+  }
+
+  static bool SameOwner(const Value& l, const Value& r) {
+    return l.Get() == r.Get() && l.ref_ == r.ref_;
+  }
+
+ public:
+  AtomicSharedPtr() = default;
+
+  explicit AtomicSharedPtr(Value value) : word_(MakeWord(std::move(value))) {
+  }
+
+  AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+  AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+  ~AtomicSharedPtr() {
+    Retire(word_.load(std::memory_order_acquire));
+  }
+
+  bool IsLockFree() const {
+    return word_.is_lock_free();
+  }
+
+  Value Load() {
+    const uint64_t word = Acquire();
+    Node* node = NodeOf(word);
+    if (!node) {
+      return Value();
+    }
+    Value result = node->value;
+    Release(node);
+    return result;
+  }
+
+  void Store(Value desired) {
+    Exchange(std::move(desired));
+  }
+
+  Value Exchange(Value desired) {
+    const uint64_t old = word_.exchange(MakeWord(std::move(desired)), std::memory_order_acq_rel);
+    Node* node = NodeOf(old);
+    if (!node) {
+      return Value();
+    }
+    // Читатели могут еще копировать value, поэтому забираем копию, а не перемещаем
+    Value result = node->value;
+    Retire(old);
+    return result;
+  }
+
+  // Если внутри тот же указатель с тем же владельцем, что и expected, кладет desired и
+  // возвращает true; иначе записывает текущее значение в expected.
+  // Сравнивается только узел: читатели постоянно двигают счетчик в слове, но если узел тот же,
+  // CAS повторяется с новым счетчиком и переносит его в узел, так что поток чтений писателя не душит.
+  bool CompareExchange(Value& expected, Value desired) {
+    uint64_t fresh = 0;
+    while (true) {
+      const uint64_t word = Acquire();
+      Node* node = NodeOf(word);
+      const bool match = node ? SameOwner(node->value, expected) : !expected;
+      if (!match) {
+        expected = node ? node->value : Value();
+        if (node) {
+          Release(node);
+        }
+        if (fresh) {
+          delete NodeOf(fresh);
+        }
+        return false;
+      }
+      if (!fresh) {
+        fresh = MakeWord(std::move(desired));
+      }
+      uint64_t current = word;
+      while (NodeOf(current) == node) {
+        if (word_.compare_exchange_weak(current, fresh, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+          Retire(current, node ? 1 : 0);
+          return true;
+        }
+      }
+      // Узел заменил другой писатель: сравниваем заново уже с ним
+      if (node) {
+        Release(node);
+      }
+    }
+  }
+};
+
+#endif  // ATOMIC_SHARED_PTR_H
@@ -0,0 +1,321 @@
+#ifndef INTRUSIVE_PTR_H
+#define INTRUSIVE_PTR_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.hpp"
+
+// Счетчик живет в самом объекте (наследнике RefCounted), поэтому IntrusivePtr - это один указатель,
+// а объект - одна аллокация без блока. Слабые ссылки нужны редко, и для них при первом
+// IntrusiveWeakPtr создается отдельная таблица.
+
+template <typename T>
+class IntrusivePtr;
+
+template <typename T>
+class IntrusiveWeakPtr;
+
+class SpinLock {
+ private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+
+ public:
+  void lock() {  // NOLINT
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+      while (flag_.test(std::memory_order_relaxed)) {
+      }
+    }
+  }
+
+  void unlock() {  // NOLINT
+    flag_.clear(std::memory_order_release);
+  }
+};
+
+// Таблица слабых ссылок: указатель на счетчик объекта, который зануляется под спинлоком перед
+// удалением объекта. Саму таблицу держат IntrusiveWeakPtr и, пока жив, объект.
+template <typename Policy>
+class IntrusiveWeakTable {
+ private:
+  using Counter = typename Policy::Counter;
+
+  SpinLock lock_;
+  Counter* strong_;
+  Counter weak_count_{1};
+
+ public:
+  explicit IntrusiveWeakTable(Counter* strong) : strong_(strong) {
+  }
+
+  void AddWeak() {
+    Policy::Increment(weak_count_);
+  }
+
+  void ReleaseWeak() {
+    if (Policy::Decrement(weak_count_) == 0) {
+      delete this;
+    }
+  }
+
+  // Пока держим спинлок, объект не удалят, а обнуленный счетчик значит, что удаление уже началось
+  bool TryLock() {
+    std::lock_guard<SpinLock> guard(lock_);
+    return strong_ && Policy::IncrementIfNonZero(*strong_);
+  }
+
+  std::size_t UseCount() {
+    std::lock_guard<SpinLock> guard(lock_);
+    return strong_ ? Policy::Load(*strong_) : 0;
+  }
+
+  void Detach() {
+    {
+      std::lock_guard<SpinLock> guard(lock_);
+      strong_ = nullptr;
+    }
+    ReleaseWeak();
+  }
+};
+
+// Базовый класс для объектов под IntrusivePtr: struct Node : RefCounted<Node> { ... }.
+// Derived нужен, чтобы удалять объект настоящего типа без виртуального деструктора.
+template <typename Derived, typename Policy = SingleThreadedPolicy>
+class RefCounted {
+ private:
+  mutable typename Policy::Counter ref_count_{0};
+  mutable std::atomic<IntrusiveWeakTable<Policy>*> weak_table_{nullptr};
+
+  void AddRef() const {
+    Policy::Increment(ref_count_);
+  }
+
+  void ReleaseRef() const {
+    if (Policy::Decrement(ref_count_) != 0) {
+      return;
+    }
+    if (auto* table = weak_table_.load(std::memory_order_acquire)) {
+      table->Detach();
+    }
+    delete static_cast<const Derived*>(this);
+  }
+
+  bool TryAddRef() const {
+    return Policy::IncrementIfNonZero(ref_count_);
+  }
+
+  // Вызывается, только когда у вызывающего есть сильная ссылка, так что объект жив
+  IntrusiveWeakTable<Policy>* WeakTable() const {
+    auto* table = weak_table_.load(std::memory_order_acquire);
+    if (table) {
+      return table;
+    }
+    auto* fresh = new IntrusiveWeakTable<Policy>(&ref_count_);
+    if (weak_table_.compare_exchange_strong(table, fresh, std::memory_order_acq_rel)) {
+      return fresh;
+    }
+    delete fresh;
+    return table;
+  }
+
+ protected:
+  RefCounted() = default;
+
+  // Копия объекта - новый объект со своими владельцами
+  RefCounted(const RefCounted&) : RefCounted() {
+  }
+
+  RefCounted& operator=(const RefCounted&) {
+    return *this;
+  }
+
+  ~RefCounted() = default;
+
+ public:
+  using RefCountPolicy = Policy;
+
+  std::size_t UseCount() const {
+    return Policy::Load(ref_count_);
+  }
+
+  template <typename U>
+  friend class IntrusivePtr;
+
+  template <typename U>
+  friend class IntrusiveWeakPtr;
+};
+
+template <typename T>
+class IntrusivePtr {
+ private:
+  T* ptr_ = nullptr;
+
+  struct AdoptTag {};
+
+  // Ссылка уже посчитана (TryAddRef в IntrusiveWeakPtr::Lock)
+  IntrusivePtr(T* ptr, AdoptTag) : ptr_(ptr) {
+  }
+
+ public:
+  IntrusivePtr() = default;
+
+  IntrusivePtr(std::nullptr_t) {  // NOLINT
+  }
+
+  // Счетчик нового объекта равен нулю, первый IntrusivePtr делает его единицей. Повторно оборачивать
+  // объект, у которого уже есть владельцы, тоже можно - счетчик общий.
+  explicit IntrusivePtr(T* ptr) : ptr_(ptr) {
+    if (ptr_) {
+      ptr_->AddRef();
+    }
+  }
+
+  IntrusivePtr(const IntrusivePtr& second_ptr) : IntrusivePtr(second_ptr.ptr_) {
+  }
+
+  IntrusivePtr(IntrusivePtr&& second_ptr) noexcept : ptr_(std::exchange(second_ptr.ptr_, nullptr)) {
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  IntrusivePtr(const IntrusivePtr<U>& second_ptr) : IntrusivePtr(second_ptr.Get()) {  // NOLINT
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  IntrusivePtr(IntrusivePtr<U>&& second_ptr) noexcept : ptr_(second_ptr.Detach()) {  // NOLINT
+  }
+
+  ~IntrusivePtr() {
+    if (ptr_) {
+      ptr_->ReleaseRef();
+    }
+  }
+
+  IntrusivePtr& operator=(const IntrusivePtr& second_ptr) {
+    IntrusivePtr(second_ptr).Swap(*this);
+    return *this;
+  }
+
+  IntrusivePtr& operator=(IntrusivePtr&& second_ptr) noexcept {
+    IntrusivePtr(std::move(second_ptr)).Swap(*this);
+    return *this;
+  }
+
+  void Reset(T* ptr = nullptr) {
+    IntrusivePtr(ptr).Swap(*this);
+  }
+
+  void Swap(IntrusivePtr& second_ptr) {
+    std::swap(ptr_, second_ptr.ptr_);
+  }
+
+  // Отдает указатель вместе с его ссылкой, не уменьшая счетчик
+  T* Detach() {
+    return std::exchange(ptr_, nullptr);
+  }
+
+  T* Get() const {
+    return ptr_;
+  }
+
+  std::size_t UseCount() const {
+    return ptr_ ? ptr_->UseCount() : 0;
+  }
+
+  T& operator*() const {
+    return *ptr_;
+  }
+
+  T* operator->() const {
+    return ptr_;
+  }
+
+  explicit operator bool() const {
+    return ptr_ != nullptr;
+  }
+
+  friend bool operator==(const IntrusivePtr& l, const IntrusivePtr& r) {
+    return l.ptr_ == r.ptr_;
+  }
+
+  template <typename U>
+  friend class IntrusiveWeakPtr;
+};
+
+template <typename T>
+class IntrusiveWeakPtr {
+ private:
+  using Table = IntrusiveWeakTable<typename T::RefCountPolicy>;
+
+  T* ptr_ = nullptr;
+  Table* table_ = nullptr;
+
+ public:
+  IntrusiveWeakPtr() = default;
+
+  IntrusiveWeakPtr(const IntrusivePtr<T>& shared)  // NOLINT
+      : ptr_(shared.Get()), table_(shared ? shared->WeakTable() : nullptr) {
+    if (table_) {
+      table_->AddWeak();
+    }
+  }
+
+  IntrusiveWeakPtr(const IntrusiveWeakPtr& second_ptr) : ptr_(second_ptr.ptr_), table_(second_ptr.table_) {
+    if (table_) {
+      table_->AddWeak();
+    }
+  }
+
+  IntrusiveWeakPtr(IntrusiveWeakPtr&& second_ptr) noexcept
+      : ptr_(std::exchange(second_ptr.ptr_, nullptr)), table_(std::exchange(second_ptr.table_, nullptr)) {
+  }
+
+  ~IntrusiveWeakPtr() {
+    if (table_) {
+      table_->ReleaseWeak();
+    }
+  }
+
+  IntrusiveWeakPtr& operator=(const IntrusiveWeakPtr& second_ptr) {
+    IntrusiveWeakPtr(second_ptr).Swap(*this);
+    return *this;
+  }
+
+  IntrusiveWeakPtr& operator=(IntrusiveWeakPtr&& second_ptr) noexcept {
+    IntrusiveWeakPtr(std::move(second_ptr)).Swap(*this);
+    return *this;
+  }
+
+  void Reset() {
+    IntrusiveWeakPtr().Swap(*this);
+  }
+
+  void Swap(IntrusiveWeakPtr& second_ptr) {
+    std::swap(ptr_, second_ptr.ptr_);
+    std::swap(table_, second_ptr.table_);
+  }
+
+  std::size_t UseCount() const {
+    return table_ ? table_->UseCount() : 0;
+  }
+
+  bool Expired() const {
+    return UseCount() == 0;
+  }
+
+  IntrusivePtr<T> Lock() const {
+    if (table_ && table_->TryLock()) {
+      return IntrusivePtr<T>(ptr_, typename IntrusivePtr<T>::AdoptTag{});
+    }
+    return IntrusivePtr<T>();
+  }
+};
+
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeIntrusive(Args&&... args) {
+  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+#endif  // INTRUSIVE_PTR_H
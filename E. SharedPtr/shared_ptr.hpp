@@ -2,9 +2,52 @@
 #define SHARED_PTR_H
 #define WEAK_PTR_IMPLEMENTED
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
 #include <cstddef>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+// С -DSHARED_PTR_DIAGNOSTICS каждый блок регистрируется в глобальном реестре вместе с местом создания,
+// типом объекта и временем, а каждый SharedPtr - как владелец. По реестру можно напечатать живые блоки
+// (ReportSharedPtrStats), выгрузить граф владения в DOT (DumpSharedPtrGraph) и найти объекты, до которых
+// не дойти от владельцев вне объектов, - обычно это циклы (ReportSharedPtrCycles).
+// Без флага все это пустые функции, а SharedPtr и блоки остаются того же размера.
+// Место создания ищется через dladdr, так что на glibc старше 2.34 нужен -ldl.
+#ifdef SHARED_PTR_DIAGNOSTICS
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <iomanip>
+#include <map>
+#include <source_location>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+#define SHARED_PTR_SITE std::source_location site = std::source_location::current()
+#define SHARED_PTR_SITE_AFTER , SHARED_PTR_SITE
+#define SHARED_PTR_SITE_FORWARD , site
+// Фабрики запоминают свой адрес возврата; встроенная фабрика вернула бы адрес чужого кадра
+#define SHARED_PTR_FACTORY [[gnu::noinline]]
+#else
+#define SHARED_PTR_SITE
+#define SHARED_PTR_SITE_AFTER
+#define SHARED_PTR_SITE_FORWARD
+#define SHARED_PTR_FACTORY
+#endif
 
 struct BadWeakPtr : public std::exception {
   const char* what() const noexcept override {
@@ -12,35 +55,912 @@ struct BadWeakPtr : public std::exception {
   }
 };
 
-template <typename T>
+// Политика счетчиков по умолчанию: обычные size_t, для указателей, которые не уходят в другие потоки
+struct SingleThreadedPolicy {
+  using Counter = std::size_t;
+
+  static constexpr bool kDeferredReclaim = false;
+
+  static void Increment(Counter& counter) {
+    ++counter;
+  }
+
+  static std::size_t Decrement(Counter& counter) {
+    return --counter;
+  }
+
+  static bool IncrementIfNonZero(Counter& counter) {
+    if (counter == 0) {
+      return false;
+    }
+    ++counter;
+    return true;
+  }
+
+  static std::size_t Load(const Counter& counter) {
+    return counter;
+  }
+};
+
+// Атомарные счетчики. Увеличение relaxed: новый владелец получен от уже живого, так что объект
+// жив в любом случае. Уменьшение acq_rel: все записи владельцев должны быть видны тому, кто удаляет.
+struct AtomicPolicy {
+  using Counter = std::atomic<std::size_t>;
+
+  static constexpr bool kDeferredReclaim = false;
+
+  static void Increment(Counter& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static std::size_t Decrement(Counter& counter) {
+    return counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  }
+
+  // Для перехода от слабой ссылки к сильной: ноль значит, что объект уже разрушается
+  static bool IncrementIfNonZero(Counter& counter) {
+    std::size_t current = counter.load(std::memory_order_relaxed);
+    while (current != 0) {
+      if (counter.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static std::size_t Load(const Counter& counter) {
+    return counter.load(std::memory_order_acquire);
+  }
+};
+
+// Отложенное удаление: последний SharedPtr не разрушает объект сам, а кладет его в список своего
+// потока, и DeferredReclaimer разрушает такие объекты пачками. Счетчики - как у Base.
+template <typename Base>
+struct Deferred : Base {
+  static constexpr bool kDeferredReclaim = true;
+  // С обычными size_t объект нельзя отдавать в другой поток: его WeakPtr могут жить здесь
+  static constexpr bool kBackgroundReclaim = !std::is_same_v<typename Base::Counter, std::size_t>;
+};
+
+// Разрушает отложенные объекты. Каждый поток копит их в своем списке; полная пачка (или Flush)
+// уходит фоновому потоку, а QuiescentPoint разрушает все накопленное в вызывающем потоке сразу.
+// Объекты с Deferred<SingleThreadedPolicy> в фон не уходят и разрушаются пачками в своем потоке.
+class DeferredReclaimer {
+ public:
+  struct Retired {
+    void* block;
+    void (*reclaim)(void*);
+  };
+
+ private:
+  static constexpr std::size_t kBatchSize = 256;
+
+  struct LocalLists {
+    std::vector<Retired> background;
+    std::vector<Retired> local;
+
+    ~LocalLists() {
+      Reclaim(local);
+      if (!shut_down_.load(std::memory_order_acquire)) {
+        Instance().HandOff(std::move(background));
+      } else {
+        Reclaim(background);
+      }
+      dead_ = true;
+    }
+  };
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::vector<std::vector<Retired>> batches_;
+  std::size_t busy_ = 0;
+  bool stop_ = false;
+  std::thread worker_;
+
+  // Тривиальные флаги остаются валидны и после разрушения списков и самого DeferredReclaimer.
+  // shut_down_ пишется при выходе, а читают его все потоки, поэтому он атомарный
+  static inline std::atomic<bool> shut_down_ = false;
+  static inline thread_local bool dead_ = false;
+
+  static LocalLists& Local() {
+    static thread_local LocalLists lists;
+    return lists;
+  }
+
+  // Разрушение объекта может отпустить другие отложенные объекты, они разбираются тем же циклом
+  static void Reclaim(std::vector<Retired>& retired) {
+    while (!retired.empty()) {
+      std::vector<Retired> batch;
+      batch.swap(retired);
+      for (const auto& item : batch) {
+        item.reclaim(item.block);
+      }
+    }
+  }
+
+  void HandOff(std::vector<Retired>&& batch) {
+    if (batch.empty()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batches_.push_back(std::move(batch));
+    }
+    wake_.notify_one();
+  }
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this] { return stop_ || !batches_.empty(); });
+      if (batches_.empty()) {
+        return;
+      }
+      std::vector<std::vector<Retired>> batches;
+      batches.swap(batches_);
+      ++busy_;
+      lock.unlock();
+      for (auto& batch : batches) {
+        Reclaim(batch);
+      }
+      LocalLists& own = Local();
+      Reclaim(own.local);
+      Reclaim(own.background);
+      lock.lock();
+      --busy_;
+      if (batches_.empty() && busy_ == 0) {
+        idle_.notify_all();
+      }
+    }
+  }
+
+  DeferredReclaimer() : worker_([this] { WorkerLoop(); }) {
+  }
+
+  ~DeferredReclaimer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+    shut_down_.store(true, std::memory_order_release);
+  }
+
+  static DeferredReclaimer& Instance() {
+    static DeferredReclaimer reclaimer;
+    return reclaimer;
+  }
+
+ public:
+  DeferredReclaimer(const DeferredReclaimer&) = delete;
+  DeferredReclaimer& operator=(const DeferredReclaimer&) = delete;
+
+  static void Retire(Retired retired, bool background) {
+    if (dead_ || shut_down_.load(std::memory_order_acquire)) {
+      retired.reclaim(retired.block);
+      return;
+    }
+    LocalLists& lists = Local();
+    auto& list = background ? lists.background : lists.local;
+    list.push_back(retired);
+    if (list.size() < kBatchSize) {
+      return;
+    }
+    if (background) {
+      Instance().HandOff(std::move(list));
+      list.clear();
+    } else {
+      Reclaim(list);
+    }
+  }
+
+  // Точка покоя: разрушить все, что этот поток успел отложить, прямо сейчас
+  static void QuiescentPoint() {
+    if (dead_) {
+      return;
+    }
+    LocalLists& lists = Local();
+    Reclaim(lists.local);
+    Reclaim(lists.background);
+  }
+
+  // Отдать неполную пачку фоновому потоку, не дожидаясь kBatchSize
+  static void Flush() {
+    if (dead_ || shut_down_.load(std::memory_order_acquire)) {
+      return;
+    }
+    LocalLists& lists = Local();
+    Reclaim(lists.local);
+    Instance().HandOff(std::move(lists.background));
+    lists.background.clear();
+  }
+
+  // Дождаться, пока фоновый поток разберет все отданные ему пачки
+  static void WaitIdle() {
+    if (shut_down_.load(std::memory_order_acquire)) {
+      return;
+    }
+    DeferredReclaimer& reclaimer = Instance();
+    std::unique_lock<std::mutex> lock(reclaimer.mutex_);
+    reclaimer.idle_.wait(lock, [&] { return reclaimer.batches_.empty() && reclaimer.busy_ == 0; });
+  }
+};
+
+template <typename T, typename Policy = SingleThreadedPolicy>
 class SharedPtr;
 
-template <typename T>
+template <typename T, typename Policy = SingleThreadedPolicy>
 class WeakPtr;
 
-template <typename T>
+template <typename T, typename Policy = SingleThreadedPolicy>
+class EnableSharedFromThis;
+
+// SharedPtr<T> может владеть U, если U* неявно приводится к T* (наследник к базе, T к const T).
+// Для массивов наследник не подходит: сдвиг по Derived[] как по Base[] попадет мимо элементов.
+template <typename U, typename T>
+struct IsCompatible : std::is_convertible<U*, T*> {};
+
+template <typename U, typename T>
+struct IsCompatible<U[], T[]> : std::is_convertible<U (*)[], T (*)[]> {};
+
+template <typename U, typename T>
+using EnableIfConvertible = std::enable_if_t<IsCompatible<U, T>::value>;
+
+// Сырой указатель U* для SharedPtr<T[]> - это указатель на первый элемент массива U[].
+// U[] появляется только в специализации для массивов, так что U = void (malloc) не ломает подстановку.
+template <typename U, typename T>
+struct OwnedType {
+  using Type = U;
+};
+
+template <typename U, typename T>
+struct OwnedType<U, T[]> {
+  using Type = U[];
+};
+
+template <typename U, typename T>
+using EnableIfPointerConvertible = EnableIfConvertible<typename OwnedType<U, T>::Type, T>;
+
+namespace shared_ptr_detail {
+
+#ifdef SHARED_PTR_DIAGNOSTICS
+
+// Счетчики читаются через функции, потому что реестр не знает политику блока
+struct BlockInfo {
+  const void* object = nullptr;
+  std::size_t object_size = 0;
+  const std::type_info* type = nullptr;
+  std::source_location location;
+  // MakeShared и AllocateShared не могут принять source_location после пакета аргументов,
+  // для них запоминается адрес возврата, а в отчете он переводится в модуль и смещение
+  const void* caller = nullptr;
+  std::chrono::steady_clock::time_point created;
+  std::size_t (*strong)(const void*) = nullptr;
+  std::size_t (*weak)(const void*) = nullptr;
+};
+
+// Копия реестра на один момент: блоки со счетчиками и ребра "владелец внутри объекта from держит to".
+// Владельцы, которые не лежат ни в одном живом объекте (стек, глобальные, чужая куча), - корни.
+// Сами указатели читаются без синхронизации, поэтому снимок имеет смысл, пока их не меняют другие потоки.
+struct Snapshot {
+  struct Block {
+    const void* address;
+    BlockInfo info;
+    std::size_t strong;
+    std::size_t weak;
+    double age;
+    bool reachable = false;
+  };
+
+  std::vector<Block> blocks;
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  std::map<std::size_t, std::size_t> roots;
+
+  static std::string Demangle(const char* symbol) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(symbol, nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : symbol;
+    std::free(demangled);
+    return name;
+  }
+
+  static std::string TypeName(const std::type_info* type) {
+    return Demangle(type->name());
+  }
+
+  // Голый адрес при ASLR бесполезен, поэтому печатается модуль и смещение от его начала:
+  // "модуль+0xсмещение" или "модуль(функция+0xсдвиг)+0xсмещение", если функция экспортирована.
+  // Для PIE и разделяемых библиотек строку понимает addr2line -f -C -i -e модуль смещение.
+  // Адрес возврата указывает за инструкцию вызова, поэтому берется байт перед ним.
+  static std::string CallerName(const void* caller) {
+    std::ostringstream out;
+    const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(caller) - 1;
+    Dl_info module{};
+    if (!dladdr(reinterpret_cast<const void*>(address), &module) || !module.dli_fname) {
+      out << "caller " << caller;
+      return out.str();
+    }
+    out << module.dli_fname;
+    if (module.dli_sname && module.dli_saddr) {
+      out << "(" << Demangle(module.dli_sname) << "+0x" << std::hex
+          << address - reinterpret_cast<std::uintptr_t>(module.dli_saddr) << ")";
+    }
+    out << "+0x" << std::hex << address - reinterpret_cast<std::uintptr_t>(module.dli_fbase);
+    return out.str();
+  }
+
+  static std::string SiteName(const BlockInfo& info) {
+    if (info.caller) {
+      return CallerName(info.caller);
+    }
+    return std::string(info.location.file_name()) + ":" + std::to_string(info.location.line());
+  }
+
+  void MarkReachable() {
+    std::vector<std::vector<std::size_t>> children(blocks.size());
+    for (const auto& [from, to] : edges) {
+      children[from].push_back(to);
+    }
+    std::vector<std::size_t> stack;
+    for (const auto& [root, count] : roots) {
+      stack.push_back(root);
+    }
+    while (!stack.empty()) {
+      const std::size_t current = stack.back();
+      stack.pop_back();
+      if (std::exchange(blocks[current].reachable, true)) {
+        continue;
+      }
+      stack.insert(stack.end(), children[current].begin(), children[current].end());
+    }
+  }
+};
+
+class BlockRegistry {
+ private:
+  std::mutex mutex_;
+  std::unordered_map<const void*, BlockInfo> blocks_;
+  std::unordered_map<const void*, const void* (*)(const void*)> owners_;
+
+ public:
+  // Реестр намеренно не разрушается: глобальные SharedPtr отписываются и после выхода из main
+  static BlockRegistry& Instance() {
+    static BlockRegistry* registry = new BlockRegistry;
+    return *registry;
+  }
+
+  void AddBlock(const void* block, const BlockInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_[block] = info;
+  }
+
+  void RemoveBlock(const void* block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.erase(block);
+  }
+
+  // slot - адрес поля ref_ в SharedPtr, read достает из него блок
+  void AddOwner(const void* slot, const void* (*read)(const void*)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    owners_[slot] = read;
+  }
+
+  void RemoveOwner(const void* slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    owners_.erase(slot);
+  }
+
+  Snapshot Take() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Snapshot snapshot;
+    const auto now = std::chrono::steady_clock::now();
+    std::unordered_map<const void*, std::size_t> index;
+    for (const auto& [address, info] : blocks_) {
+      index[address] = snapshot.blocks.size();
+      snapshot.blocks.push_back({address, info, info.strong(address), info.weak(address),
+                                 std::chrono::duration<double>(now - info.created).count()});
+    }
+    // Живые объекты по адресу начала, чтобы быстро найти объект, внутри которого лежит владелец
+    std::vector<std::size_t> alive;
+    for (std::size_t i = 0; i < snapshot.blocks.size(); ++i) {
+      if (snapshot.blocks[i].strong > 0 && snapshot.blocks[i].info.object_size > 0) {
+        alive.push_back(i);
+      }
+    }
+    auto begin_of = [&](std::size_t i) { return static_cast<const char*>(snapshot.blocks[i].info.object); };
+    std::sort(alive.begin(), alive.end(), [&](std::size_t l, std::size_t r) { return begin_of(l) < begin_of(r); });
+    for (const auto& [slot, read] : owners_) {
+      const auto target = index.find(read(slot));
+      if (target == index.end()) {
+        continue;
+      }
+      const char* place = static_cast<const char*>(slot);
+      auto next = std::upper_bound(alive.begin(), alive.end(), place,
+                                   [&](const char* value, std::size_t i) { return value < begin_of(i); });
+      if (next != alive.begin()) {
+        const std::size_t container = *std::prev(next);
+        if (place < begin_of(container) + snapshot.blocks[container].info.object_size) {
+          snapshot.edges.emplace_back(container, target->second);
+          continue;
+        }
+      }
+      ++snapshot.roots[target->second];
+    }
+    snapshot.MarkReachable();
+    return snapshot;
+  }
+};
+
+#endif
+
+// Поле SharedPtr, которое записывает сам SharedPtr в реестр владельцев; без флага пустое
+template <typename Policy>
+class OwnerSlot {
+#ifdef SHARED_PTR_DIAGNOSTICS
+ private:
+  const void* slot_;
+
+ public:
+  template <typename Block>
+  explicit OwnerSlot(Block* const* slot) : slot_(slot) {
+    BlockRegistry::Instance().AddOwner(slot_, [](const void* owner) -> const void* {
+      return *static_cast<Block* const*>(owner);
+    });
+  }
+
+  ~OwnerSlot() {
+    BlockRegistry::Instance().RemoveOwner(slot_);
+  }
+#else
+ public:
+  template <typename Block>
+  constexpr explicit OwnerSlot(Block* const*) {
+  }
+#endif
+
+  OwnerSlot(const OwnerSlot&) = delete;
+  OwnerSlot& operator=(const OwnerSlot&) = delete;
+};
+
+}  // namespace shared_ptr_detail
+
+// Живые блоки по местам создания: сколько их, сильные и слабые ссылки, возраст самого старого.
+// Без SHARED_PTR_DIAGNOSTICS ничего не делает.
+inline void ReportSharedPtrStats(std::ostream& out = std::cerr) {
+#ifdef SHARED_PTR_DIAGNOSTICS
+  const auto snapshot = shared_ptr_detail::BlockRegistry::Instance().Take();
+  struct Row {
+    std::size_t blocks = 0;
+    std::size_t expired = 0;
+    std::size_t strong = 0;
+    std::size_t weak = 0;
+    double oldest = 0;
+  };
+  std::map<std::pair<std::string, std::string>, Row> rows;
+  Row total;
+  for (const auto& block : snapshot.blocks) {
+    for (Row* row : {&rows[{shared_ptr_detail::Snapshot::SiteName(block.info),
+                            shared_ptr_detail::Snapshot::TypeName(block.info.type)}],
+                     &total}) {
+      ++row->blocks;
+      row->expired += block.strong == 0;
+      row->strong += block.strong;
+      row->weak += block.weak;
+      row->oldest = std::max(row->oldest, block.age);
+    }
+  }
+  out << std::fixed << std::setprecision(3);
+  out << "SharedPtr live blocks: " << total.blocks << " (" << total.expired << " expired), strong " << total.strong
+      << ", weak " << total.weak << "\n";
+  out << std::setw(10) << "blocks" << std::setw(10) << "expired" << std::setw(10) << "strong" << std::setw(10)
+      << "weak" << std::setw(12) << "oldest, s"
+      << "  site  type\n";
+  for (const auto& [key, row] : rows) {
+    out << std::setw(10) << row.blocks << std::setw(10) << row.expired << std::setw(10) << row.strong
+        << std::setw(10) << row.weak << std::setw(12) << row.oldest << "  " << key.first << "  " << key.second << "\n";
+  }
+#else
+  (void)out;
+#endif
+}
+
+// Граф владения в формате DOT: узел - блок, ребро - SharedPtr внутри объекта, roots - владельцы снаружи.
+// Недостижимые от roots живые объекты выделены красным.
+inline void DumpSharedPtrGraph(std::ostream& out) {
+#ifdef SHARED_PTR_DIAGNOSTICS
+  const auto snapshot = shared_ptr_detail::BlockRegistry::Instance().Take();
+  out << "digraph SharedPtr {\n  roots [shape=box];\n";
+  for (const auto& block : snapshot.blocks) {
+    out << "  \"" << block.address << "\" [label=\"" << shared_ptr_detail::Snapshot::TypeName(block.info.type)
+        << "\\n" << shared_ptr_detail::Snapshot::SiteName(block.info) << "\\nstrong " << block.strong << ", weak "
+        << block.weak << ", " << block.age << " s\"";
+    if (block.strong == 0) {
+      out << " style=dashed";
+    } else if (!block.reachable) {
+      out << " color=red";
+    }
+    out << "];\n";
+  }
+  for (const auto& [target, count] : snapshot.roots) {
+    out << "  roots -> \"" << snapshot.blocks[target].address << "\" [label=" << count << "];\n";
+  }
+  for (const auto& [from, to] : snapshot.edges) {
+    out << "  \"" << snapshot.blocks[from].address << "\" -> \"" << snapshot.blocks[to].address << "\";\n";
+  }
+  out << "}\n";
+#else
+  out << "digraph SharedPtr {\n}\n";
+#endif
+}
+
+// Живые объекты, которых держат только другие объекты, но не держит ни один внешний владелец.
+// Владельцы, лежащие в отдельной памяти объекта (например, в буфере его std::vector), считаются
+// внешними, поэтому циклы через контейнеры так не находятся. Возвращает число таких объектов.
+inline std::size_t ReportSharedPtrCycles(std::ostream& out = std::cerr) {
+#ifdef SHARED_PTR_DIAGNOSTICS
+  const auto snapshot = shared_ptr_detail::BlockRegistry::Instance().Take();
+  std::size_t unreachable = 0;
+  for (const auto& block : snapshot.blocks) {
+    if (block.strong > 0 && !block.reachable) {
+      ++unreachable;
+      out << "unreachable " << shared_ptr_detail::Snapshot::TypeName(block.info.type) << " at "
+          << block.info.object << " from " << shared_ptr_detail::Snapshot::SiteName(block.info) << ", strong "
+          << block.strong << ", weak " << block.weak << ", " << block.age << " s\n";
+    }
+  }
+  return unreachable;
+#else
+  (void)out;
+  return 0;
+#endif
+}
+
+// Все сильные владельцы вместе держат одну слабую ссылку: блок удаляет тот, кто обнулил weak_count_,
+// и гонки между последним SharedPtr и последним WeakPtr нет.
+// Как разрушить объект и освободить блок, решает наследник: DestroyObject вызывается при обнулении
+// strong_count_, DestroyBlock - при обнулении weak_count_. Тип объекта в блоке стерт, поэтому
+// SharedPtr<Base> и SharedPtr<Derived> могут делить один блок.
+template <typename Policy = SingleThreadedPolicy>
 struct RefCounter {
-  std::size_t strong_count_ = 1;
-  std::size_t weak_count_ = 0;
+  typename Policy::Counter strong_count_{1};
+  typename Policy::Counter weak_count_{1};
+
+  RefCounter() = default;
+  RefCounter(const RefCounter&) = delete;
+  RefCounter& operator=(const RefCounter&) = delete;
+#ifdef SHARED_PTR_DIAGNOSTICS
+  virtual ~RefCounter() {
+    shared_ptr_detail::BlockRegistry::Instance().RemoveBlock(this);
+  }
+#else
+  virtual ~RefCounter() = default;
+#endif
+
+  virtual void DestroyObject() = 0;
+
+  virtual void DestroyBlock() {
+    delete this;
+  }
+
+  // Сильных владельцев не осталось: разрушить объект и отпустить их общую слабую ссылку
+  void ReleaseObject() {
+    DestroyObject();
+    if (Policy::Decrement(weak_count_) == 0) {
+      DestroyBlock();
+    }
+  }
 };
 
-template <typename T>
+// Пул блоков одного размера: у каждого потока свой список свободных блоков, без блокировок.
+// Блок, освобожденный в другом потоке, просто попадает в список этого потока.
+template <std::size_t kSize>
+class ControlBlockPool {
+ private:
+  struct Chunk {
+    Chunk* next;
+  };
+
+  static constexpr std::size_t kMaxCached = 4096;
+
+  // Тривиальные thread_local живут до конца потока, так что блоки можно возвращать даже
+  // из деструкторов других thread_local, уже после очистки списка
+  static inline thread_local Chunk* free_ = nullptr;
+  static inline thread_local std::size_t cached_ = 0;
+  static inline thread_local bool drained_ = false;
+
+  struct Drainer {
+    ~Drainer() {
+      while (free_) {
+        ::operator delete(std::exchange(free_, free_->next));
+      }
+      cached_ = 0;
+      drained_ = true;
+    }
+  };
+
+  static_assert(kSize >= sizeof(Chunk));
+
+ public:
+  static void* Allocate() {
+    if (!free_) {
+      return ::operator new(kSize);
+    }
+    --cached_;
+    return std::exchange(free_, free_->next);
+  }
+
+  static void Deallocate(void* ptr) {
+    if (drained_ || cached_ == kMaxCached) {
+      ::operator delete(ptr);
+      return;
+    }
+    static thread_local Drainer drainer;
+    free_ = new (ptr) Chunk{free_};
+    ++cached_;
+  }
+};
+
+// Блок для SharedPtr(T*): объект выделен отдельно, а сам блок берется из ControlBlockPool.
+// Для SharedPtr<T[]> T - это массив, и объект удаляется через delete[].
+template <typename T, typename Policy>
+struct PointerRefCounter : RefCounter<Policy> {
+  std::remove_extent_t<T>* ptr_;
+
+  explicit PointerRefCounter(std::remove_extent_t<T>* ptr) : ptr_(ptr) {
+  }
+
+  void DestroyObject() override {
+    if constexpr (std::is_array_v<T>) {
+      delete[] ptr_;
+    } else {
+      delete ptr_;
+    }
+  }
+
+  static void* operator new(std::size_t) {
+    return ControlBlockPool<sizeof(PointerRefCounter)>::Allocate();
+  }
+
+  static void operator delete(void* ptr) {
+    ControlBlockPool<sizeof(PointerRefCounter)>::Deallocate(ptr);
+  }
+};
+
+// Блок для MakeShared: объект лежит прямо в блоке, одна аллокация на все.
+// После разрушения объекта память живет, пока есть WeakPtr.
+template <typename T, typename Policy>
+struct InlineRefCounter : RefCounter<Policy> {
+  alignas(T) unsigned char storage_[sizeof(T)];
+
+  template <typename... Args>
+  explicit InlineRefCounter(Args&&... args) {
+    // ::new - чтобы operator new самого T (пул объектов и т.п.) не перекрыл размещающий new
+    ::new (static_cast<void*>(storage_)) T(std::forward<Args>(args)...);
+  }
+
+  T* Get() {
+    return std::launder(reinterpret_cast<T*>(storage_));
+  }
+
+  void DestroyObject() override {
+    Get()->~T();
+  }
+};
+
+// Блок для AllocateShared: как InlineRefCounter, но память и объект - через аллокатор пользователя,
+// копия которого хранится в самом блоке
+template <typename T, typename Policy, typename Alloc>
+struct AllocatedRefCounter : RefCounter<Policy> {
+  using ValueAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<AllocatedRefCounter>;
+
+  ValueAlloc alloc_;
+  alignas(T) unsigned char storage_[sizeof(T)];
+
+  template <typename... Args>
+  explicit AllocatedRefCounter(const Alloc& alloc, Args&&... args) : alloc_(alloc) {
+    std::allocator_traits<ValueAlloc>::construct(alloc_, reinterpret_cast<T*>(storage_), std::forward<Args>(args)...);
+  }
+
+  T* Get() {
+    return std::launder(reinterpret_cast<T*>(storage_));
+  }
+
+  void DestroyObject() override {
+    std::allocator_traits<ValueAlloc>::destroy(alloc_, Get());
+  }
+
+  void DestroyBlock() override {
+    BlockAlloc alloc(alloc_);
+    this->~AllocatedRefCounter();
+    std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+  }
+};
+
+// Блок для SharedPtr(ptr, deleter[, alloc]): объект удаляет deleter, блок выделен через alloc
+template <typename T, typename Policy, typename Deleter, typename Alloc>
+struct DeleterRefCounter : RefCounter<Policy> {
+  using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<DeleterRefCounter>;
+
+  T* ptr_;
+  Deleter deleter_;
+  BlockAlloc alloc_;
+
+  DeleterRefCounter(T* ptr, Deleter&& deleter, const Alloc& alloc)
+      : ptr_(ptr), deleter_(std::move(deleter)), alloc_(alloc) {
+  }
+
+  void DestroyObject() override {
+    deleter_(ptr_);
+  }
+
+  void DestroyBlock() override {
+    BlockAlloc alloc(alloc_);
+    this->~DeleterRefCounter();
+    std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+  }
+};
+
+// Блок для MakeSharedArray: n элементов лежат сразу за блоком в той же аллокации
+template <typename T, typename Policy>
+struct ArrayRefCounter : RefCounter<Policy> {
+  std::size_t size_;
+
+  explicit ArrayRefCounter(std::size_t size) : size_(size) {
+  }
+
+  static constexpr std::size_t kAlign = std::max(alignof(RefCounter<Policy>), alignof(T));
+
+  // Первый элемент - сразу за блоком, с выравниванием T
+  static constexpr std::size_t Offset() {
+    return (sizeof(ArrayRefCounter) + alignof(T) - 1) / alignof(T) * alignof(T);
+  }
+
+  // Память выделяется здесь, а не в operator new, потому что ее размер зависит от n
+  static ArrayRefCounter* Create(std::size_t size, bool default_init) {
+    if (size > (std::numeric_limits<std::size_t>::max() - Offset()) / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    void* memory = ::operator new(Offset() + size * sizeof(T), std::align_val_t{kAlign});
+    auto* block = new (memory) ArrayRefCounter(size);
+    try {
+      if (default_init) {
+        std::uninitialized_default_construct_n(block->Get(), size);
+      } else {
+        std::uninitialized_value_construct_n(block->Get(), size);
+      }
+    } catch (...) {
+      block->~ArrayRefCounter();
+      ::operator delete(memory, std::align_val_t{kAlign});
+      throw;
+    }
+    return block;
+  }
+
+  T* Get() {
+    return std::launder(reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(this) + Offset()));
+  }
+
+  void DestroyObject() override {
+    std::destroy_n(Get(), size_);
+  }
+
+  void DestroyBlock() override {
+    this->~ArrayRefCounter();
+    ::operator delete(static_cast<void*>(this), std::align_val_t{kAlign});
+  }
+};
+
+template <typename T, typename Policy>
 class SharedPtr {
+ public:
+  using ElementType = std::remove_extent_t<T>;
+
  private:
-  T* ptr_ = nullptr;
-  RefCounter<T>* ref_ = nullptr;
+  ElementType* ptr_ = nullptr;
+  RefCounter<Policy>* ref_ = nullptr;
+  [[no_unique_address]] shared_ptr_detail::OwnerSlot<Policy> owner_{&ref_};
 
   void ToTrash() {
-    delete ptr_;
+    if constexpr (Policy::kDeferredReclaim) {
+      // strong_count_ уже ноль, так что WeakPtr::Lock объект не вернет, пока он ждет разрушения
+      DeferredReclaimer::Retire(
+          {ref_, [](void* block) { static_cast<RefCounter<Policy>*>(block)->ReleaseObject(); }},
+          Policy::kBackgroundReclaim);
+    } else {
+      ref_->ReleaseObject();
+    }
     ptr_ = nullptr;
-    if (ref_->weak_count_ == 0) {
-      delete ref_;
-      ref_ = nullptr;
+    ref_ = nullptr;
+  }
+
+  // Если блок выделить не удалось, объект все равно удаляется, как у std::shared_ptr
+  template <typename U>
+  static RefCounter<Policy>* NewRefCounter(U* ptr) {
+    try {
+      return new PointerRefCounter<typename OwnedType<U, T>::Type, Policy>(ptr);
+    } catch (...) {
+      if constexpr (std::is_array_v<T>) {
+        delete[] ptr;
+      } else {
+        delete ptr;
+      }
+      throw;
+    }
+  }
+
+  template <typename U, typename Deleter, typename Alloc>
+  static RefCounter<Policy>* NewRefCounter(U* ptr, Deleter& deleter, const Alloc& alloc) {
+    using Block = DeleterRefCounter<U, Policy, Deleter, Alloc>;
+    typename Block::BlockAlloc block_alloc(alloc);
+    Block* ref = nullptr;
+    try {
+      ref = std::allocator_traits<typename Block::BlockAlloc>::allocate(block_alloc, 1);
+    } catch (...) {
+      deleter(ptr);
+      throw;
+    }
+    return new (ref) Block(ptr, std::move(deleter), alloc);
+  }
+
+  // Блок идет первым, чтобы не путаться с SharedPtr(ptr, deleter). Ссылка в блоке уже посчитана.
+  SharedPtr(RefCounter<Policy>* ref, ElementType* ptr) : ptr_(ptr), ref_(ref) {
+  }
+
+  // Если объект наследует EnableSharedFromThis и еще никому не принадлежит, запоминаем в нем владельца
+  template <typename U>
+  void HookSharedFromThis(U* ptr) {
+    if constexpr (requires { typename U::SharedFromThisType; }) {
+      using X = typename U::SharedFromThisType;
+      static_assert(std::is_same_v<typename U::SharedFromThisPolicy, Policy>,
+                    "EnableSharedFromThis and SharedPtr must use the same policy");
+      auto* object = const_cast<std::remove_cv_t<U>*>(ptr);
+      if (!object) {
+        return;
+      }
+      auto& weak_this = object->EnableSharedFromThis<X, Policy>::weak_this_;
+      if (weak_this.Expired()) {
+        weak_this.Reset();
+        weak_this.ptr_ = static_cast<X*>(object);
+        weak_this.ref_ = ref_;
+        Policy::Increment(ref_->weak_count_);
+      }
+    }
+  }
+
+#ifdef SHARED_PTR_DIAGNOSTICS
+  template <typename U>
+  void Track(U* object, std::source_location location, const void* caller = nullptr, std::size_t count = 1) {
+    shared_ptr_detail::BlockInfo info;
+    info.object = static_cast<const void*>(object);
+    if constexpr (!std::is_void_v<U>) {
+      info.object_size = sizeof(U) * count;
     }
+    info.type = &typeid(U);
+    info.location = location;
+    info.caller = caller;
+    info.created = std::chrono::steady_clock::now();
+    info.strong = [](const void* block) {
+      return Policy::Load(static_cast<const RefCounter<Policy>*>(block)->strong_count_);
+    };
+    info.weak = [](const void* block) {
+      const auto* ref = static_cast<const RefCounter<Policy>*>(block);
+      const std::size_t strong = Policy::Load(ref->strong_count_);
+      return Policy::Load(ref->weak_count_) - (strong > 0 ? 1 : 0);
+    };
+    shared_ptr_detail::BlockRegistry::Instance().AddBlock(static_cast<const void*>(ref_), info);
+  }
+#else
+  template <typename U>
+  void Track(U*) {
   }
+#endif
 
   void Release() {
-    if ((ref_) && (--ref_->strong_count_ == 0)) {
+    if ((ref_) && (Policy::Decrement(ref_->strong_count_) == 0)) {
       ToTrash();
     }
   }
@@ -48,15 +968,51 @@ class SharedPtr {
  public:
   SharedPtr() = default;
 
-  explicit SharedPtr(T* ptr) : ptr_(ptr) {
+  SharedPtr(std::nullptr_t) {  // NOLINT
+  }
+
+  // Блок помнит настоящий тип U, так что SharedPtr<Base>(new Derived) удалит Derived
+  template <typename U, typename = EnableIfPointerConvertible<U, T>>
+  explicit SharedPtr(U* ptr SHARED_PTR_SITE_AFTER) : ptr_(ptr) {
     if (ptr) {
-      ref_ = new RefCounter<T>();
+      ref_ = NewRefCounter(ptr);
+      Track(ptr SHARED_PTR_SITE_FORWARD);
+      HookSharedFromThis(ptr);
     }
   }
 
+  // deleter(ptr) вызывается при обнулении счетчика; блок создается и для nullptr
+  template <typename U, typename Deleter, typename = EnableIfPointerConvertible<U, T>>
+  SharedPtr(U* ptr, Deleter deleter SHARED_PTR_SITE_AFTER)
+      : ptr_(ptr), ref_(NewRefCounter(ptr, deleter, std::allocator<char>())) {
+    Track(ptr SHARED_PTR_SITE_FORWARD);
+    HookSharedFromThis(ptr);
+  }
+
+  template <typename U, typename Deleter, typename Alloc, typename = EnableIfPointerConvertible<U, T>>
+  SharedPtr(U* ptr, Deleter deleter, const Alloc& alloc SHARED_PTR_SITE_AFTER)
+      : ptr_(ptr), ref_(NewRefCounter(ptr, deleter, alloc)) {
+    Track(ptr SHARED_PTR_SITE_FORWARD);
+    HookSharedFromThis(ptr);
+  }
+
+  // Aliasing: владеем тем же, что owner, а указываем на ptr (обычно поле или кусок объекта owner)
+  template <typename U>
+  SharedPtr(const SharedPtr<U, Policy>& owner, ElementType* ptr) : ptr_(ptr), ref_(owner.ref_) {
+    if (ref_) {
+      Policy::Increment(ref_->strong_count_);
+    }
+  }
+
+  template <typename U>
+  SharedPtr(SharedPtr<U, Policy>&& owner, ElementType* ptr) noexcept : ptr_(ptr), ref_(owner.ref_) {
+    owner.ptr_ = nullptr;
+    owner.ref_ = nullptr;
+  }
+
   SharedPtr(const SharedPtr& second_ptr) : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {
     if (ref_) {
-      ++ref_->strong_count_;
+      Policy::Increment(ref_->strong_count_);
     }
   }
 
@@ -65,41 +1021,60 @@ class SharedPtr {
     second_ptr.ref_ = nullptr;
   }
 
-  explicit SharedPtr(const WeakPtr<T>& weak_count) {
-    if (!weak_count.ref_ || weak_count.ref_->strong_count_ == 0) {
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  SharedPtr(const SharedPtr<U, Policy>& second_ptr) : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {  // NOLINT
+    if (ref_) {
+      Policy::Increment(ref_->strong_count_);
+    }
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  SharedPtr(SharedPtr<U, Policy>&& second_ptr) noexcept  // NOLINT
+      : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {
+    second_ptr.ptr_ = nullptr;
+    second_ptr.ref_ = nullptr;
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  explicit SharedPtr(const WeakPtr<U, Policy>& weak_count) {
+    if (!weak_count.ref_ || !Policy::IncrementIfNonZero(weak_count.ref_->strong_count_)) {
       throw BadWeakPtr{};
     }
     ptr_ = weak_count.ptr_;
     ref_ = weak_count.ref_;
-    ++ref_->strong_count_;
   }
 
   ~SharedPtr() {
     Release();
   }
 
-  void Reset(T* ptr = nullptr) {
+  void Reset() {
     Release();
-    if (ptr) {
-      ptr_ = ptr;
-      ref_ = new RefCounter<T>();
-      return;
-    }
     ptr_ = nullptr;
     ref_ = nullptr;
   }
 
+  template <typename U, typename = EnableIfPointerConvertible<U, T>>
+  void Reset(U* ptr SHARED_PTR_SITE_AFTER) {
+    SharedPtr(ptr SHARED_PTR_SITE_FORWARD).Swap(*this);
+  }
+
+  template <typename U, typename Deleter, typename = EnableIfPointerConvertible<U, T>>
+  void Reset(U* ptr, Deleter deleter SHARED_PTR_SITE_AFTER) {
+    SharedPtr(ptr, std::move(deleter) SHARED_PTR_SITE_FORWARD).Swap(*this);
+  }
+
   void Swap(SharedPtr& second_ptr) {
     std::swap(ptr_, second_ptr.ptr_);
     std::swap(ref_, second_ptr.ref_);
   }
 
-  T* Get() const {
+  ElementType* Get() const {
     return ptr_;
   }
 
   std::size_t UseCount() const {
-    return ref_ ? ref_->strong_count_ : 0;
+    return ref_ ? Policy::Load(ref_->strong_count_) : 0;
   }
 
   SharedPtr& operator=(const SharedPtr& second_ptr) {
@@ -108,7 +1083,7 @@ class SharedPtr {
       ptr_ = second_ptr.ptr_;
       ref_ = second_ptr.ref_;
       if (ref_) {
-        ++ref_->strong_count_;
+        Policy::Increment(ref_->strong_count_);
       }
     }
     return *this;
@@ -125,34 +1100,70 @@ class SharedPtr {
     return *this;
   }
 
-  T& operator*() const {
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  SharedPtr& operator=(const SharedPtr<U, Policy>& second_ptr) {
+    SharedPtr(second_ptr).Swap(*this);
+    return *this;
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  SharedPtr& operator=(SharedPtr<U, Policy>&& second_ptr) noexcept {
+    SharedPtr(std::move(second_ptr)).Swap(*this);
+    return *this;
+  }
+
+  // add_lvalue_reference нужен, чтобы SharedPtr<void> (например, с munmap в deleter) компилировался
+  std::add_lvalue_reference_t<T> operator*() const requires(!std::is_array_v<T>) {
     return *ptr_;
   }
 
-  T* operator->() const {
+  T* operator->() const requires(!std::is_array_v<T>) {
     return ptr_;
   }
 
+  std::add_lvalue_reference_t<ElementType> operator[](std::ptrdiff_t index) const requires std::is_array_v<T> {
+    return ptr_[index];
+  }
+
   explicit operator bool() const {
     return ptr_ != nullptr;
   }
 
-  friend class WeakPtr<T>;
+  template <typename U, typename P>
+  friend class SharedPtr;
+
+  template <typename U, typename P>
+  friend class WeakPtr;
+
+  template <typename U>
+  friend class AtomicSharedPtr;
+
+  template <typename U, typename P, typename... Args>
+  friend SharedPtr<U, P> MakeShared(Args&&... args);
+
+  template <typename U, typename P, typename Alloc, typename... Args>
+  friend SharedPtr<U, P> AllocateShared(const Alloc& alloc, Args&&... args);
+
+  template <typename U, typename P>
+  friend SharedPtr<U[], P> MakeSharedArray(std::size_t size);
+
+  template <typename U, typename P>
+  friend SharedPtr<U[], P> MakeSharedArrayDefaultInit(std::size_t size);
 };
 
-template <typename T>
+template <typename T, typename Policy>
 class WeakPtr {
  private:
-  T* ptr_ = nullptr;
-  RefCounter<T>* ref_ = nullptr;
+  std::remove_extent_t<T>* ptr_ = nullptr;
+  RefCounter<Policy>* ref_ = nullptr;
 
   void ToTrash() {
-    delete ref_;
+    ref_->DestroyBlock();
     ref_ = nullptr;
   }
 
   void Release() {
-    if ((ref_) && (--ref_->weak_count_ == 0 && ref_->strong_count_ == 0)) {
+    if ((ref_) && (Policy::Decrement(ref_->weak_count_) == 0)) {
       ToTrash();
     }
   }
@@ -160,15 +1171,29 @@ class WeakPtr {
  public:
   WeakPtr() = default;
 
-  WeakPtr(const SharedPtr<T>& shared) : ptr_(shared.ptr_), ref_(shared.ref_) { // NOLINT
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  WeakPtr(const SharedPtr<U, Policy>& shared) : ptr_(shared.ptr_), ref_(shared.ref_) { // NOLINT
     if (ref_) {
-      ++ref_->weak_count_;
+      Policy::Increment(ref_->weak_count_);
     }
   }
 
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  WeakPtr(const WeakPtr<U, Policy>& second_ptr) : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {  // NOLINT
+    if (ref_) {
+      Policy::Increment(ref_->weak_count_);
+    }
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  WeakPtr(WeakPtr<U, Policy>&& second_ptr) noexcept : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {  // NOLINT
+    second_ptr.ptr_ = nullptr;
+    second_ptr.ref_ = nullptr;
+  }
+
   WeakPtr(const WeakPtr& second_ptr) : ptr_(second_ptr.ptr_), ref_(second_ptr.ref_) {
     if (ref_) {
-      ++ref_->weak_count_;
+      Policy::Increment(ref_->weak_count_);
     }
   }
 
@@ -193,18 +1218,19 @@ class WeakPtr {
   }
 
   std::size_t UseCount() const {
-    return ref_ ? ref_->strong_count_ : 0;
+    return ref_ ? Policy::Load(ref_->strong_count_) : 0;
   }
 
   bool Expired() const {
-    return !ref_ || ref_->strong_count_ == 0;
+    return !ref_ || Policy::Load(ref_->strong_count_) == 0;
   }
 
-  SharedPtr<T> Lock() const {
-    if (!Expired()) {
-      return SharedPtr<T>(*this);
+  // Проверка и захват - одно действие, так что с AtomicPolicy объект не может умереть между ними
+  SharedPtr<T, Policy> Lock() const noexcept {
+    if (ref_ && Policy::IncrementIfNonZero(ref_->strong_count_)) {
+      return SharedPtr<T, Policy>(ref_, ptr_);
     }
-    return SharedPtr<T>();
+    return SharedPtr<T, Policy>();
   }
 
   WeakPtr& operator=(const WeakPtr& second_ptr) {
@@ -213,7 +1239,7 @@ class WeakPtr {
       ptr_ = second_ptr.ptr_;
       ref_ = second_ptr.ref_;
       if (ref_) {
-        ++ref_->weak_count_;
+        Policy::Increment(ref_->weak_count_);
       }
     }
     return *this;
@@ -230,24 +1256,122 @@ class WeakPtr {
     return *this;
   }
 
-  WeakPtr& operator=(const SharedPtr<T>& shared) {
-    if (ref_ != shared.ref_) {
-      Release();
-      ptr_ = shared.ptr_;
-      ref_ = shared.ref_;
-      if (ref_) {
-        ++ref_->weak_count_;
-      }
-    }
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  WeakPtr& operator=(const SharedPtr<U, Policy>& shared) {
+    WeakPtr(shared).Swap(*this);
+    return *this;
+  }
+
+  template <typename U, typename = EnableIfConvertible<U, T>>
+  WeakPtr& operator=(const WeakPtr<U, Policy>& second_ptr) {
+    WeakPtr(second_ptr).Swap(*this);
     return *this;
   }
 
-  friend class SharedPtr<T>;
+  template <typename U, typename P>
+  friend class SharedPtr;
+
+  template <typename U, typename P>
+  friend class WeakPtr;
 };
 
-template <typename T, typename... Args>
-SharedPtr<T> MakeShared(Args&&... args) {
-  return SharedPtr<T>(new T(std::forward<Args>(args)...));
+template <typename T, typename Policy = SingleThreadedPolicy, typename... Args>
+SHARED_PTR_FACTORY SharedPtr<T, Policy> MakeShared(Args&&... args) {
+  auto* ref = new InlineRefCounter<T, Policy>(std::forward<Args>(args)...);
+  SharedPtr<T, Policy> result(ref, ref->Get());
+#ifdef SHARED_PTR_DIAGNOSTICS
+  result.Track(result.Get(), std::source_location(), __builtin_return_address(0));
+#endif
+  result.HookSharedFromThis(result.Get());
+  return result;
+}
+
+template <typename T, typename Policy = SingleThreadedPolicy, typename Alloc, typename... Args>
+SHARED_PTR_FACTORY SharedPtr<T, Policy> AllocateShared(const Alloc& alloc, Args&&... args) {
+  using Block = AllocatedRefCounter<T, Policy, Alloc>;
+  typename Block::BlockAlloc block_alloc(alloc);
+  Block* ref = std::allocator_traits<typename Block::BlockAlloc>::allocate(block_alloc, 1);
+  try {
+    new (ref) Block(alloc, std::forward<Args>(args)...);
+  } catch (...) {
+    std::allocator_traits<typename Block::BlockAlloc>::deallocate(block_alloc, ref, 1);
+    throw;
+  }
+  SharedPtr<T, Policy> result(ref, ref->Get());
+#ifdef SHARED_PTR_DIAGNOSTICS
+  result.Track(result.Get(), std::source_location(), __builtin_return_address(0));
+#endif
+  result.HookSharedFromThis(result.Get());
+  return result;
+}
+
+// Массив из size элементов и блок - одна аллокация; элементы value-инициализируются (нули для int)
+template <typename T, typename Policy = SingleThreadedPolicy>
+SHARED_PTR_FACTORY SharedPtr<T[], Policy> MakeSharedArray(std::size_t size) {
+  auto* ref = ArrayRefCounter<T, Policy>::Create(size, false);
+  SharedPtr<T[], Policy> result(ref, ref->Get());
+#ifdef SHARED_PTR_DIAGNOSTICS
+  result.Track(result.Get(), std::source_location(), __builtin_return_address(0), size);
+#endif
+  return result;
+}
+
+// То же, но элементы default-инициализируются: для тривиальных T память не трогается,
+// что и нужно буферу, который сразу перезапишут (read, recv)
+template <typename T, typename Policy = SingleThreadedPolicy>
+SHARED_PTR_FACTORY SharedPtr<T[], Policy> MakeSharedArrayDefaultInit(std::size_t size) {
+  auto* ref = ArrayRefCounter<T, Policy>::Create(size, true);
+  SharedPtr<T[], Policy> result(ref, ref->Get());
+#ifdef SHARED_PTR_DIAGNOSTICS
+  result.Track(result.Get(), std::source_location(), __builtin_return_address(0), size);
+#endif
+  return result;
 }
 
+// Базовый класс для объектов, которым нужно получить SharedPtr на себя: struct Session :
+// EnableSharedFromThis<Session> { ... }. Владелец запоминается, когда объект впервые попадает
+// в SharedPtr (конструктор из указателя, MakeShared, AllocateShared).
+template <typename T, typename Policy>
+class EnableSharedFromThis {
+ private:
+  mutable WeakPtr<T, Policy> weak_this_;
+
+ protected:
+  EnableSharedFromThis() = default;
+
+  // Копия объекта - другой объект, владельца не наследует
+  EnableSharedFromThis(const EnableSharedFromThis&) {
+  }
+
+  EnableSharedFromThis& operator=(const EnableSharedFromThis&) {
+    return *this;
+  }
+
+  ~EnableSharedFromThis() = default;
+
+ public:
+  using SharedFromThisType = T;
+  using SharedFromThisPolicy = Policy;
+
+  // Бросает BadWeakPtr, если объект еще не в SharedPtr или уже разрушается
+  SharedPtr<T, Policy> SharedFromThis() {
+    return SharedPtr<T, Policy>(weak_this_);
+  }
+
+  SharedPtr<const T, Policy> SharedFromThis() const {
+    return SharedPtr<const T, Policy>(weak_this_);
+  }
+
+  WeakPtr<T, Policy> WeakFromThis() noexcept {
+    return weak_this_;
+  }
+
+  WeakPtr<const T, Policy> WeakFromThis() const noexcept {
+    return weak_this_;
+  }
+
+  template <typename U, typename P>
+  friend class SharedPtr;
+};
+
 #endif  // SHARED_PTR_H
\ No newline at end of file
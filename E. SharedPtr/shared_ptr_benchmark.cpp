@@ -0,0 +1,225 @@
+#include "atomic_shared_ptr.hpp"
+#include "intrusive_ptr.hpp"
+#include "shared_ptr.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 1. Копирование и разрушение одного и того же SharedPtr из многих потоков: все они бьют в один счетчик.
+// 2. SharedPtr против IntrusivePtr в одном потоке: копирование, создание и удаление, разыменование.
+// 3. Публикация конфига: kThreads - 1 читателей и один писатель, AtomicSharedPtr против мьютекса.
+// 4. Задержка запроса, который отпускает большой граф: удаление на месте против Deferred.
+// Число итераций можно передать первым аргументом.
+
+namespace {
+
+const int kThreads = 32;
+
+template <typename Policy>
+double Measure(int threads, size_t iterations) {
+  const auto shared = MakeShared<int, Policy>(42);
+  std::vector<std::thread> workers;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&shared, iterations] {
+      for (size_t j = 0; j < iterations; ++j) {
+        SharedPtr<int, Policy> copy(shared);
+        if (*copy != 42) {
+          std::abort();
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  const auto finish = std::chrono::steady_clock::now();
+  if (shared.UseCount() != 1) {
+    std::cerr << "reference count is broken\n";
+    std::exit(1);
+  }
+  return std::chrono::duration<double>(finish - start).count();
+}
+
+void Print(const char* name, int threads, size_t iterations, double seconds) {
+  std::cout << name << ", " << threads << " thread(s): " << seconds << " s, "
+            << seconds * 1e9 / (iterations * threads) << " ns per copy\n";
+}
+
+struct SharedNode {
+  int value = 1;
+};
+
+struct IntrusiveNode : RefCounted<IntrusiveNode> {
+  int value = 1;
+};
+
+template <typename F>
+double Time(F fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// volatile-приемник, чтобы компилятор не выкинул циклы
+volatile int sink = 0;
+
+template <typename Ptr, typename Make>
+void CompareOne(const char* name, size_t iterations, Make make) {
+  const Ptr origin = make();
+  const double copy = Time([&] {
+    for (size_t i = 0; i < iterations; ++i) {
+      Ptr copy(origin);
+      sink = sink + copy->value;
+    }
+  });
+
+  const double create = Time([&] {
+    for (size_t i = 0; i < iterations; ++i) {
+      Ptr fresh = make();
+      sink = sink + fresh->value;
+    }
+  });
+
+  // Разыменование в разбросанном по памяти массиве: здесь важен размер указателя и лишний блок
+  std::vector<Ptr> nodes;
+  nodes.reserve(iterations);
+  for (size_t i = 0; i < iterations; ++i) {
+    nodes.push_back(make());
+  }
+  const double deref = Time([&] {
+    int sum = 0;
+    for (const auto& node : nodes) {
+      sum += node->value;
+    }
+    sink = sum;
+  });
+  const double destroy = Time([&] { nodes.clear(); });
+
+  std::cout << name << ": copy " << copy * 1e9 / iterations << " ns, create " << create * 1e9 / iterations
+            << " ns, deref " << deref * 1e9 / iterations << " ns, destroy " << destroy * 1e9 / iterations
+            << " ns, sizeof " << sizeof(Ptr) << "\n";
+}
+
+struct Config {
+  int generation = 0;
+};
+
+using ConfigPtr = SharedPtr<Config, AtomicPolicy>;
+
+class LockedConfig {
+ private:
+  std::mutex mutex_;
+  ConfigPtr config_;
+
+ public:
+  explicit LockedConfig(ConfigPtr config) : config_(std::move(config)) {
+  }
+
+  ConfigPtr Load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+  }
+
+  void Store(ConfigPtr config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_.Swap(config);
+  }
+};
+
+// Читатели крутят Load все время, писатель раз в 100 мкс публикует новую версию
+template <typename Cell>
+void PublishSubscribe(const char* name, std::chrono::milliseconds duration) {
+  Cell cell(MakeShared<Config, AtomicPolicy>());
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> reads{0};
+  size_t writes = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < kThreads - 1; ++i) {
+    readers.emplace_back([&] {
+      size_t local = 0;
+      int last = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const ConfigPtr config = cell.Load();
+        if (config->generation < last) {
+          std::abort();
+        }
+        last = config->generation;
+        ++local;
+      }
+      reads += local;
+    });
+  }
+  const auto finish = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < finish) {
+    auto config = MakeShared<Config, AtomicPolicy>();
+    config->generation = static_cast<int>(++writes);
+    cell.Store(std::move(config));
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  const double seconds = std::chrono::duration<double>(duration).count();
+  std::cout << name << ": " << reads / seconds / 1e6 << " M loads/s, " << writes / seconds << " stores/s\n";
+}
+
+// Каждый запрос строит граф из kNodes узлов и отпускает его; считаем p50/p99 времени запроса.
+// С Deferred разрушение графа уходит в фоновый поток и из времени запроса пропадает.
+template <typename Policy>
+void RequestLatency(const char* name, int requests) {
+  const int kNodes = 20000;
+  using Node = SharedPtr<SharedNode, Policy>;
+  std::vector<double> latencies;
+  latencies.reserve(requests);
+  for (int i = 0; i < requests; ++i) {
+    auto graph = MakeShared<std::vector<Node>, Policy>();
+    graph->reserve(kNodes);
+    for (int j = 0; j < kNodes; ++j) {
+      graph->push_back(MakeShared<SharedNode, Policy>());
+    }
+    latencies.push_back(Time([&] {
+      int sum = 0;
+      for (const auto& node : *graph) {
+        sum += node->value;
+      }
+      sink = sum;
+      graph.Reset();
+    }));
+  }
+  DeferredReclaimer::Flush();
+  DeferredReclaimer::WaitIdle();
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << name << ": p50 " << latencies[requests / 2] * 1e6 << " us, p99 "
+            << latencies[requests * 99 / 100] * 1e6 << " us\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  Print("SingleThreadedPolicy", 1, iterations, Measure<SingleThreadedPolicy>(1, iterations));
+  Print("AtomicPolicy        ", 1, iterations, Measure<AtomicPolicy>(1, iterations));
+  Print("AtomicPolicy        ", kThreads, iterations, Measure<AtomicPolicy>(kThreads, iterations));
+
+  CompareOne<SharedPtr<SharedNode>>("SharedPtr + MakeShared", iterations, [] { return MakeShared<SharedNode>(); });
+  CompareOne<SharedPtr<SharedNode>>("SharedPtr + new       ", iterations,
+                                    [] { return SharedPtr<SharedNode>(new SharedNode); });
+  CompareOne<IntrusivePtr<IntrusiveNode>>("IntrusivePtr          ", iterations,
+                                          [] { return MakeIntrusive<IntrusiveNode>(); });
+
+  PublishSubscribe<AtomicSharedPtr<Config>>("AtomicSharedPtr     ", std::chrono::milliseconds(500));
+  PublishSubscribe<LockedConfig>("mutex + SharedPtr   ", std::chrono::milliseconds(500));
+
+  RequestLatency<AtomicPolicy>("AtomicPolicy          ", 200);
+  RequestLatency<Deferred<AtomicPolicy>>("Deferred<AtomicPolicy>", 200);
+}
@@ -1,9 +1,19 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include <atomic>
+#include <dlfcn.h>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
+#include "atomic_shared_ptr.hpp"
+#include "intrusive_ptr.hpp"
 #include "shared_ptr.hpp"
 #include "shared_ptr.hpp"  // check include guards
 
@@ -406,3 +416,623 @@ TEST_CASE("MakeShared", "[SharedPtr]") {
 }
 
 #endif  // WEAK_PTR_IMPLEMENTED
+
+TEST_CASE("AtomicPolicy", "[SharedPtr]") {
+  const auto shared = MakeShared<int, AtomicPolicy>(42);
+  const WeakPtr<int, AtomicPolicy> weak(shared);
+  std::atomic<int> broken{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&shared, &weak, &broken] {
+      for (int j = 0; j < 10000; ++j) {
+        SharedPtr<int, AtomicPolicy> copy(shared);
+        const auto locked = weak.Lock();
+        if (*copy != 42 || !locked || *locked != 42) {
+          ++broken;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(broken == 0);
+  REQUIRE(shared.UseCount() == 1);
+  REQUIRE(weak.UseCount() == 1);
+  REQUIRE(std::is_same_v<decltype(weak.Lock()), SharedPtr<int, AtomicPolicy>>);
+
+  // последний владелец уходит в другом потоке, пока этот держит только WeakPtr
+  auto last = MakeShared<std::vector<int>, AtomicPolicy>(100, 7);
+  WeakPtr<std::vector<int>, AtomicPolicy> observer(last);
+  std::thread([owner = std::move(last)]() mutable { owner.Reset(); }).join();
+  REQUIRE(observer.Expired());
+  REQUIRE(!observer.Lock());
+}
+
+namespace {
+
+// operator new класса зовется только для отдельного объекта; MakeShared кладет объект в свой блок
+struct Tracked {
+  inline static int alive = 0;
+  inline static int separate_allocations = 0;
+  int value;
+
+  explicit Tracked(int v = 0) : value(v) {
+    ++alive;
+  }
+
+  Tracked(const Tracked& other) : value(other.value) {
+    ++alive;
+  }
+
+  ~Tracked() {
+    --alive;
+  }
+
+  static void* operator new(std::size_t size) {
+    ++separate_allocations;
+    return ::operator new(size);
+  }
+
+  static void operator delete(void* ptr) {
+    ::operator delete(ptr);
+  }
+};
+
+}  // namespace
+
+TEST_CASE("MakeShared Single Allocation", "[SharedPtr]") {
+  const int separate_allocations = Tracked::separate_allocations;
+  const int alive = Tracked::alive;
+  auto ptr = MakeShared<Tracked>(5);
+  REQUIRE(Tracked::separate_allocations == separate_allocations);
+  REQUIRE(ptr->value == 5);
+  const SharedPtr<Tracked> separate(new Tracked(6));
+  REQUIRE(Tracked::separate_allocations == separate_allocations + 1);
+
+  // объект разрушается вместе с последним SharedPtr, а блок живет, пока есть WeakPtr
+  WeakPtr<Tracked> weak(ptr);
+  ptr.Reset();
+  REQUIRE(Tracked::alive == alive + 1);
+  REQUIRE(weak.Expired());
+  REQUIRE(!weak.Lock());
+}
+
+namespace {
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;  // NOLINT
+
+  int* live;
+
+  explicit CountingAllocator(int* counter) : live(counter) {
+  }
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other) : live(other.live) {  // NOLINT
+  }
+
+  T* allocate(std::size_t n) {  // NOLINT
+    ++*live;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, std::size_t n) {  // NOLINT
+    --*live;
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>& other) const {
+    return live == other.live;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("AllocateShared", "[SharedPtr]") {
+  // Счетчики Tracked общие для всех тестов, поэтому проверяются только приращения
+  const int separate_allocations = Tracked::separate_allocations;
+  const int alive = Tracked::alive;
+  int live = 0;
+  {
+    auto ptr = AllocateShared<Tracked>(CountingAllocator<Tracked>(&live), 7);
+    REQUIRE(live == 1);
+    REQUIRE(ptr->value == 7);
+    REQUIRE(Tracked::separate_allocations == separate_allocations);
+    REQUIRE(Tracked::alive == alive + 1);
+    const WeakPtr<Tracked> weak(ptr);
+    ptr.Reset();
+    REQUIRE(Tracked::alive == alive);
+    REQUIRE(live == 1);
+  }
+  REQUIRE(live == 0);
+
+  // Блок с deleter выделяется через аллокатор; deleter зовется и для нулевого указателя
+  int deleted = 0;
+  {
+    const SharedPtr<int> ptr(
+        static_cast<int*>(nullptr), [&deleted](int*) { ++deleted; }, CountingAllocator<char>(&live));
+    REQUIRE(live == 1);
+  }
+  REQUIRE(deleted == 1);
+  REQUIRE(live == 0);
+}
+
+TEST_CASE("ControlBlockPool", "[SharedPtr]") {
+  using Pool = ControlBlockPool<64>;
+  void* first = Pool::Allocate();
+  Pool::Deallocate(first);
+  void* second = Pool::Allocate();
+  REQUIRE(second == first);
+  Pool::Deallocate(second);
+
+  // блок, освобожденный в другом потоке, попадает в список того потока
+  void* shared = Pool::Allocate();
+  void* reused = nullptr;
+  std::thread([&] {
+    Pool::Deallocate(shared);
+    reused = Pool::Allocate();
+    Pool::Deallocate(reused);
+  }).join();
+  REQUIRE(reused == shared);
+
+  for (int i = 0; i < 1000; ++i) {
+    const SharedPtr<int> ptr(new int(i));
+    const SharedPtr<int> copy(ptr);
+    REQUIRE(*copy == i);
+  }
+}
+
+namespace {
+
+struct Base {
+  int base = 1;
+};
+
+// Деструктор Base не виртуальный: удалить Derived правильно может только стертый тип в блоке
+struct Derived : Base {
+  inline static int destroyed = 0;
+  std::vector<int> payload = std::vector<int>(10, 3);
+
+  ~Derived() {
+    ++destroyed;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Deleters And Conversions", "[SharedPtr]") {
+  int deleted = 0;
+  {
+    SharedPtr<int> ptr(new int(5), [&deleted](int* p) {
+      ++deleted;
+      delete p;
+    });
+    const SharedPtr<int> copy(ptr);
+    ptr.Reset(new int(6), [&deleted](int* p) {
+      deleted += 10;
+      delete p;
+    });
+    REQUIRE(deleted == 0);
+  }
+  REQUIRE(deleted == 11);
+
+  {
+    SharedPtr<Base> base(new Derived);
+    REQUIRE(base->base == 1);
+    const SharedPtr<const Base> constant(base);
+    base = MakeShared<Derived>();
+    REQUIRE(Derived::destroyed == 0);
+  }
+  REQUIRE(Derived::destroyed == 2);
+
+  {
+    auto derived = MakeShared<Derived>();
+    SharedPtr<Base> moved(std::move(derived));
+    REQUIRE(!derived);
+    REQUIRE(moved.UseCount() == 1);
+    WeakPtr<const Base> weak(moved);
+    REQUIRE(weak.Lock().Get() == moved.Get());
+  }
+  REQUIRE(Derived::destroyed == 3);
+
+  REQUIRE(std::is_constructible_v<SharedPtr<Base>, SharedPtr<Derived>>);
+  REQUIRE(!std::is_constructible_v<SharedPtr<Derived>, SharedPtr<Base>>);
+  REQUIRE(!std::is_constructible_v<SharedPtr<int>, SharedPtr<const int>>);
+}
+
+TEST_CASE("Aliasing", "[SharedPtr]") {
+  auto owner = MakeShared<std::pair<int, std::vector<int>>>(1, std::vector<int>{1, 2, 3});
+  SharedPtr<std::vector<int>> member(owner, &owner->second);
+  REQUIRE(owner.UseCount() == 2);
+  owner.Reset();
+  REQUIRE(member.UseCount() == 1);
+  REQUIRE(member->size() == 3);
+
+  const SharedPtr<int> element(std::move(member), &(*member)[1]);
+  REQUIRE(!member);
+  REQUIRE(*element == 2);
+  REQUIRE(element.UseCount() == 1);
+
+  // пустой владелец и ненулевой указатель: не владеет ничем, но указывает
+  int local = 4;
+  const SharedPtr<int> unowned(SharedPtr<int>(), &local);
+  REQUIRE(*unowned == 4);
+  REQUIRE(unowned.UseCount() == 0);
+}
+
+namespace {
+
+struct Node : RefCounted<Node> {
+  inline static int destroyed = 0;
+  int value;
+
+  explicit Node(int v = 0) : value(v) {
+  }
+
+  ~Node() {
+    ++destroyed;
+  }
+};
+
+struct SharedNode : RefCounted<SharedNode, AtomicPolicy> {
+  int value = 3;
+};
+
+}  // namespace
+
+TEST_CASE("IntrusivePtr", "[IntrusivePtr]") {
+  REQUIRE(sizeof(IntrusivePtr<Node>) == sizeof(Node*));
+  const int destroyed = Node::destroyed;
+  {
+    auto ptr = MakeIntrusive<Node>(5);
+    REQUIRE(ptr.UseCount() == 1);
+    IntrusivePtr<Node> copy(ptr);
+    REQUIRE(ptr.UseCount() == 2);
+    REQUIRE(copy == ptr);
+
+    // Счетчик в объекте, так что сырой указатель можно обернуть повторно
+    const IntrusivePtr<Node> again(ptr.Get());
+    REQUIRE(ptr.UseCount() == 3);
+
+    // Перемещение в IntrusivePtr<const Node> забирает ссылку через Detach, счетчик не меняется
+    const IntrusivePtr<const Node> adopted(std::move(copy));
+    REQUIRE(!copy);
+    REQUIRE(adopted.UseCount() == 3);
+    REQUIRE(adopted->value == 5);
+  }
+  REQUIRE(Node::destroyed - destroyed == 1);
+
+  {
+    // Копия объекта - новый объект со своим счетчиком
+    auto ptr = MakeIntrusive<Node>(1);
+    auto copy = MakeIntrusive<Node>(*ptr);
+    REQUIRE(ptr.UseCount() == 1);
+    REQUIRE(copy.UseCount() == 1);
+    ptr.Reset(new Node(2));
+    REQUIRE(ptr->value == 2);
+  }
+  REQUIRE(Node::destroyed - destroyed == 4);
+}
+
+TEST_CASE("IntrusiveWeakPtr", "[IntrusivePtr]") {
+  IntrusiveWeakPtr<Node> empty;
+  REQUIRE(empty.Expired());
+  REQUIRE(!empty.Lock());
+
+  auto ptr = MakeIntrusive<Node>(7);
+  IntrusiveWeakPtr<Node> weak(ptr);
+  IntrusiveWeakPtr<Node> copy(weak);
+  REQUIRE(weak.UseCount() == 1);
+  {
+    const auto locked = copy.Lock();
+    REQUIRE(locked->value == 7);
+    REQUIRE(ptr.UseCount() == 2);
+  }
+  const int destroyed = Node::destroyed;
+  ptr.Reset();
+  REQUIRE(Node::destroyed == destroyed + 1);
+  REQUIRE(weak.Expired());
+  REQUIRE(!copy.Lock());
+  weak.Reset();
+  REQUIRE(weak.UseCount() == 0);
+
+  // Lock в гонке с последним владельцем: либо объект целиком, либо пустой указатель
+  auto shared = MakeIntrusive<SharedNode>();
+  const IntrusiveWeakPtr<SharedNode> observer(shared);
+  std::atomic<int> broken{0};
+  std::thread reader([&] {
+    for (int i = 0; i < 10000; ++i) {
+      if (const auto locked = observer.Lock(); locked && locked->value != 3) {
+        ++broken;
+      }
+    }
+  });
+  shared.Reset();
+  reader.join();
+  REQUIRE(broken == 0);
+  REQUIRE(observer.Expired());
+}
+
+TEST_CASE("AtomicSharedPtr", "[AtomicSharedPtr]") {
+  AtomicSharedPtr<int> cell;
+  REQUIRE(!cell.Load());
+  auto first = MakeShared<int, AtomicPolicy>(1);
+  cell.Store(first);
+  REQUIRE(cell.Load().Get() == first.Get());
+  REQUIRE(first.UseCount() == 2);
+
+  auto old = cell.Exchange(MakeShared<int, AtomicPolicy>(2));
+  REQUIRE(old.Get() == first.Get());
+  REQUIRE(*cell.Load() == 2);
+  old.Reset();
+  REQUIRE(first.UseCount() == 1);
+
+  // expected не совпал: CompareExchange возвращает false и кладет в expected текущее значение
+  SharedPtr<int, AtomicPolicy> expected = first;
+  REQUIRE(!cell.CompareExchange(expected, MakeShared<int, AtomicPolicy>(3)));
+  REQUIRE(*expected == 2);
+  REQUIRE(cell.CompareExchange(expected, MakeShared<int, AtomicPolicy>(3)));
+  REQUIRE(*cell.Load() == 3);
+
+  SharedPtr<int, AtomicPolicy> none;
+  REQUIRE(!cell.CompareExchange(none, first));
+  cell.Store(nullptr);
+  none.Reset();
+  REQUIRE(cell.CompareExchange(none, first));
+  REQUIRE(cell.Load().Get() == first.Get());
+  REQUIRE(first.UseCount() == 2);
+}
+
+TEST_CASE("AtomicSharedPtr CompareExchange Under Readers", "[AtomicSharedPtr]") {
+  const int writers = 2;
+  const int increments = 2000;
+  AtomicSharedPtr<int> cell(MakeShared<int, AtomicPolicy>(0));
+  std::atomic<bool> stop{false};
+  std::atomic<int> broken{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&] {
+      int last = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const int value = *cell.Load();
+        if (value < last) {
+          ++broken;
+        }
+        last = value;
+      }
+    });
+  }
+  std::vector<std::thread> updaters;
+  for (int i = 0; i < writers; ++i) {
+    updaters.emplace_back([&] {
+      for (int j = 0; j < increments; ++j) {
+        auto expected = cell.Load();
+        while (!cell.CompareExchange(expected, MakeShared<int, AtomicPolicy>(*expected + 1))) {
+        }
+      }
+    });
+  }
+  for (auto& updater : updaters) {
+    updater.join();
+  }
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(broken == 0);
+  REQUIRE(*cell.Load() == writers * increments);
+  REQUIRE(cell.Load().UseCount() == 2);
+}
+
+namespace {
+
+struct Session : EnableSharedFromThis<Session> {
+  int id = 9;
+};
+
+struct AtomicSession : EnableSharedFromThis<AtomicSession, AtomicPolicy> {};
+
+}  // namespace
+
+TEST_CASE("EnableSharedFromThis", "[SharedPtr]") {
+  Session unowned;
+  REQUIRE_THROWS_AS(unowned.SharedFromThis(), BadWeakPtr);
+  REQUIRE(unowned.WeakFromThis().Expired());
+
+  auto session = MakeShared<Session>();
+  auto self = session->SharedFromThis();
+  REQUIRE(self.Get() == session.Get());
+  REQUIRE(session.UseCount() == 2);
+  const Session& constant = *session;
+  const SharedPtr<const Session> const_self = constant.SharedFromThis();
+  REQUIRE(session.UseCount() == 3);
+
+  // Копия объекта - другой объект, владельца она не наследует
+  Session copy(*session);
+  REQUIRE_THROWS_AS(copy.SharedFromThis(), BadWeakPtr);
+
+  const SharedPtr<Session> separate(new Session);
+  REQUIRE(separate->SharedFromThis().Get() == separate.Get());
+
+  auto weak = session->WeakFromThis();
+  self.Reset();
+  session.Reset();
+  REQUIRE(!weak.Expired());
+  REQUIRE(weak.Lock()->id == 9);
+
+  auto atomic = MakeShared<AtomicSession, AtomicPolicy>();
+  REQUIRE(atomic->SharedFromThis().Get() == atomic.Get());
+}
+
+TEST_CASE("Lock Without Exceptions", "[WeakPtr]") {
+  REQUIRE(noexcept(WeakPtr<int>().Lock()));
+  WeakPtr<int> weak;
+  REQUIRE(!weak.Lock());
+  {
+    const auto ptr = MakeShared<int>(1);
+    weak = ptr;
+    REQUIRE(*weak.Lock() == 1);
+  }
+  const auto locked = weak.Lock();
+  REQUIRE(!locked);
+  REQUIRE(locked.UseCount() == 0);
+  REQUIRE_THROWS_AS(SharedPtr<int>(weak), BadWeakPtr);
+}
+
+namespace {
+
+// Разрушается в фоновом потоке, пока основной еще создает такие же, поэтому счетчик атомарный
+struct Retiree {
+  inline static std::atomic<int> alive = 0;
+
+  Retiree() {
+    ++alive;
+  }
+
+  ~Retiree() {
+    --alive;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("DeferredReclaimer", "[SharedPtr]") {
+  Tracked::alive = 0;
+  DeferredReclaimer::QuiescentPoint();
+  {
+    using Policy = Deferred<SingleThreadedPolicy>;
+    auto ptr = MakeShared<Tracked, Policy>(1);
+    WeakPtr<Tracked, Policy> weak = ptr;
+    ptr.Reset();
+    // Объект ждет точки покоя, но владельцем его уже не вернуть
+    REQUIRE(Tracked::alive == 1);
+    REQUIRE(weak.Expired());
+    REQUIRE(!weak.Lock());
+    DeferredReclaimer::QuiescentPoint();
+    REQUIRE(Tracked::alive == 0);
+  }
+  {
+    using Policy = Deferred<AtomicPolicy>;
+    std::vector<SharedPtr<Tracked, Policy>> ptrs;
+    for (int i = 0; i < 10; ++i) {
+      ptrs.push_back(MakeShared<Tracked, Policy>(i));
+    }
+    WeakPtr<Tracked, Policy> weak = ptrs.front();
+    ptrs.clear();
+    REQUIRE(!weak.Lock());
+    DeferredReclaimer::Flush();
+    DeferredReclaimer::WaitIdle();
+    REQUIRE(Tracked::alive == 0);
+  }
+  {
+    // Целая пачка уходит в фон без Flush
+    using Policy = Deferred<AtomicPolicy>;
+    for (int i = 0; i < 1000; ++i) {
+      MakeShared<Retiree, Policy>();
+    }
+    DeferredReclaimer::Flush();
+    DeferredReclaimer::WaitIdle();
+    REQUIRE(Retiree::alive == 0);
+  }
+}
+
+namespace {
+
+struct Link {
+  SharedPtr<Link> next;
+};
+
+}  // namespace
+
+TEST_CASE("Diagnostics", "[SharedPtr]") {
+  std::ostringstream report;
+  std::ostringstream graph;
+  auto first = MakeShared<Link>();
+  auto second = MakeShared<Link>();
+  first->next = second;
+  second->next = first;
+  WeakPtr<Link> weak = first;
+  first.Reset();
+  second.Reset();
+  REQUIRE(!weak.Expired());
+  ReportSharedPtrStats(report);
+  DumpSharedPtrGraph(graph);
+#ifdef SHARED_PTR_DIAGNOSTICS
+  REQUIRE(ReportSharedPtrCycles(report) >= 2);
+  REQUIRE(report.str().find("unreachable") != std::string::npos);
+  REQUIRE(graph.str().find("color=red") != std::string::npos);
+
+  // MakeShared записан как модуль теста со смещением, а не как голый адрес
+  Dl_info module{};
+  void (*probe)() = [] {};
+  REQUIRE(dladdr(reinterpret_cast<void*>(probe), &module) != 0);
+  REQUIRE(report.str().find(module.dli_fname) != std::string::npos);
+  REQUIRE(report.str().find("caller 0x") == std::string::npos);
+#else
+  REQUIRE(ReportSharedPtrCycles(report) == 0);
+  REQUIRE(report.str().empty());
+  REQUIRE(graph.str() == "digraph SharedPtr {\n}\n");
+#endif
+  // Разрываем цикл, чтобы не оставить утечку
+  weak.Lock()->next.Reset();
+  REQUIRE(weak.Expired());
+#ifdef SHARED_PTR_DIAGNOSTICS
+  std::ostringstream after;
+  REQUIRE(ReportSharedPtrCycles(after) == 0);
+#endif
+}
+
+namespace {
+
+struct Free {
+  void operator()(void* ptr) const {
+    std::free(ptr);
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Void And Arrays", "[SharedPtr]") {
+  {
+    SharedPtr<void> ptr(std::malloc(10), Free());
+    REQUIRE(ptr.Get() != nullptr);
+    const SharedPtr<void> copy = ptr;
+    REQUIRE(ptr.UseCount() == 2);
+    const SharedPtr<void> from_int = MakeShared<int>(3);
+    REQUIRE(*static_cast<int*>(from_int.Get()) == 3);
+  }
+  {
+    auto zeroed = MakeSharedArray<int>(5);
+    for (std::ptrdiff_t i = 0; i < 5; ++i) {
+      REQUIRE(zeroed[i] == 0);
+      zeroed[i] = static_cast<int>(i);
+    }
+    REQUIRE(zeroed[4] == 4);
+    static_assert(std::is_same_v<decltype(zeroed[0]), int&>);
+
+    const SharedPtr<const int[]> readonly = zeroed;
+    REQUIRE(readonly[3] == 3);
+    REQUIRE(readonly.UseCount() == 2);
+    static_assert(std::is_same_v<decltype(readonly[0]), const int&>);
+
+    auto uninit = MakeSharedArrayDefaultInit<Tracked>(4);
+    REQUIRE(uninit[3].value == 0);
+    auto empty = MakeSharedArray<int>(0);
+    REQUIRE(empty.UseCount() == 1);
+  }
+  {
+    SharedPtr<int[]> raw(new int[5]{1, 2, 3, 4, 5});
+    REQUIRE(raw[0] + raw[4] == 6);
+    SharedPtr<const int[]> moved = std::move(raw);
+    REQUIRE(!raw);
+    REQUIRE(moved[2] == 3);
+  }
+  static_assert(!std::is_constructible_v<SharedPtr<int[]>, SharedPtr<int>>);
+  static_assert(!std::is_constructible_v<SharedPtr<int>, SharedPtr<int[]>>);
+  static_assert(!std::is_constructible_v<SharedPtr<Base[]>, Derived*>);
+  static_assert(!std::is_constructible_v<SharedPtr<Base[]>, SharedPtr<Derived[]>>);
+  static_assert(std::is_constructible_v<SharedPtr<void>, int*>);
+}
@@ -0,0 +1,202 @@
+#ifndef ARANGE_HPP
+#define ARANGE_HPP
+
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "range.hpp"
+
+template <typename T>
+class Arange;
+
+namespace arange_detail {
+
+// Целая сетка длиной с BasicRange и разность итераторов берет у него же; вещественная не длиннее PTRDIFF_MAX
+template <typename T, bool = std::is_integral_v<T>>
+struct Difference {
+  using Type = std::ptrdiff_t;
+};
+
+template <typename T>
+struct Difference<T, true> {
+  using Type = typename BasicRange<T>::DifferenceType;
+};
+
+} // namespace arange_detail
+
+template <typename T>
+Arange<T> Linspace(T begin, T end, std::size_t count, bool endpoint = true);
+
+// Сетка begin, begin + step, ... с любым арифметическим шагом, как arange и linspace в numpy.
+// Элемент с номером i всегда считается как begin + i * step, а не прибавлением step к предыдущему,
+// поэтому ошибка округления не копится: у i-го элемента она та же, что у одного умножения.
+// Linspace дополнительно запоминает конец, и последний элемент равен ему точно.
+template <typename T>
+class Arange {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Arange requires an arithmetic type");
+
+public:
+  using SizeType = std::size_t;
+  using DifferenceType = typename arange_detail::Difference<T>::Type;
+
+  // Итератор хранит указатель на сетку и номер элемента; сравниваются только номера.
+  // Номер беззнаковый, как у BasicRange::Iterator, и по той же причине.
+  class Iterator {
+  private:
+    const Arange *grid_ = nullptr;
+    SizeType index_ = 0;
+
+  public:
+    // reference - prvalue T, категория все равно random access, как у BasicRange::Iterator
+    using iterator_concept = std::random_access_iterator_tag;  // NOLINT
+    using iterator_category = std::random_access_iterator_tag; // NOLINT
+    using value_type = T;                                      // NOLINT
+    using difference_type = DifferenceType;                    // NOLINT
+    using reference = T;                                       // NOLINT
+
+    Iterator() = default;
+    Iterator(const Arange *grid, SizeType index) : grid_(grid), index_(index) {}
+
+    T operator*() const { return (*grid_)[index_]; }
+    T operator[](DifferenceType offset) const { return *(*this + offset); }
+
+    Iterator &operator++() {
+      ++index_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++index_;
+      return old;
+    }
+
+    Iterator &operator--() {
+      --index_;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --index_;
+      return old;
+    }
+
+    Iterator &operator+=(DifferenceType offset) {
+      index_ += static_cast<SizeType>(offset);
+      return *this;
+    }
+
+    Iterator &operator-=(DifferenceType offset) {
+      index_ -= static_cast<SizeType>(offset);
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator it, DifferenceType offset) { return it += offset; }
+    friend Iterator operator+(DifferenceType offset, Iterator it) { return it += offset; }
+    friend Iterator operator-(Iterator it, DifferenceType offset) { return it -= offset; }
+    friend DifferenceType operator-(const Iterator &l, const Iterator &r) {
+      return static_cast<DifferenceType>(l.index_) - static_cast<DifferenceType>(r.index_);
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.index_ == r.index_; }
+    friend std::strong_ordering operator<=>(const Iterator &l, const Iterator &r) { return l.index_ <=> r.index_; }
+  };
+
+private:
+  T begin_ = 0;
+  T step_ = 1;
+  T last_ = 0;
+  SizeType size_ = 0;
+
+  friend Arange Linspace<T>(T begin, T end, std::size_t count, bool endpoint);
+
+public:
+  Arange() = default;
+  explicit Arange(T end) : Arange(0, end, 1) {}
+  Arange(T begin, T end) : Arange(begin, end, 1) {}
+
+  // Число элементов - ceil((end - begin) / step), как в numpy; нулевой шаг, NaN и бесконечности
+  // дают пустую сетку, а больше PTRDIFF_MAX элементов (разность итераторов) - std::length_error.
+  // Для целых T размер считает BasicRange, у него он точен при любых концах.
+  Arange(T begin, T end, T step) : begin_(begin), step_(step) {
+    if constexpr (std::is_integral_v<T>) {
+      size_ = BasicRange<T>(begin, end, step).Size();
+    } else {
+      const T count = std::ceil((end - begin) / step);
+      if (count > 0 && std::isfinite(count)) {
+        // 2^digits точно представимо в любом T, в отличие от PTRDIFF_MAX
+        if (count >= std::ldexp(T{1}, std::numeric_limits<DifferenceType>::digits)) {
+          throw std::length_error("Arange is too long");
+        }
+        size_ = static_cast<SizeType>(count);
+      }
+    }
+    last_ = size_ == 0 ? begin_ : At(size_ - 1);
+  }
+
+  SizeType Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+  T Step() const { return step_; }
+
+  T operator[](SizeType index) const { return index + 1 == size_ ? last_ : At(index); }
+
+  Iterator begin() const { return {this, 0}; } // NOLINT
+  Iterator end() const { return {this, size_}; } // NOLINT
+
+  // Пишет Size() элементов в out. Номер элемента переводится в T и умножается на шаг в каждой из
+  // восьми дорожек, так что блок векторизуется без накопления ошибки; последний элемент - last_.
+  template <typename U>
+  void FillInto(U *out) const {
+    constexpr SizeType kLanes = 8;
+    SizeType i = 0;
+    for (; i + kLanes <= size_; i += kLanes) {
+      for (SizeType k = 0; k < kLanes; ++k) {
+        out[i + k] = static_cast<U>(At(i + k));
+      }
+    }
+    for (; i < size_; ++i) {
+      out[i] = static_cast<U>(At(i));
+    }
+    if (size_ != 0) {
+      out[size_ - 1] = static_cast<U>(last_);
+    }
+  }
+
+private:
+  // Целые считаются по модулю 2^N в беззнаковом типе, как в BasicRange: begin + i * step может
+  // не влезть в T посередине, хотя сам элемент влезает
+  T At(SizeType index) const {
+    if constexpr (std::is_integral_v<T>) {
+      using UnsignedT = typename BasicRange<T>::UnsignedT;
+      return static_cast<T>(static_cast<UnsignedT>(begin_) +
+                            static_cast<UnsignedT>(index) * static_cast<UnsignedT>(step_));
+    } else {
+      return static_cast<T>(begin_ + static_cast<T>(index) * step_);
+    }
+  }
+};
+
+// count точек от begin до end. С endpoint шаг (end - begin) / (count - 1) и последняя точка ровно end,
+// без него шаг (end - begin) / count и end не входит.
+template <typename T>
+Arange<T> Linspace(T begin, T end, std::size_t count, bool endpoint) {
+  static_assert(std::is_floating_point_v<T>, "Linspace requires a floating-point type");
+  if (count > static_cast<std::size_t>(std::numeric_limits<std::ptrdiff_t>::max())) {
+    throw std::length_error("Linspace is too long");
+  }
+  Arange<T> grid;
+  grid.begin_ = begin;
+  grid.size_ = count;
+  const std::size_t intervals = endpoint ? count - 1 : count;
+  grid.step_ = intervals == 0 ? T{0} : (end - begin) / static_cast<T>(intervals);
+  grid.last_ = count == 0 ? begin : (endpoint && count > 1 ? end : grid.At(count - 1));
+  return grid;
+}
+
+#endif // ARANGE_HPP
@@ -0,0 +1,567 @@
+#ifndef ITERTOOLS_HPP
+#define ITERTOOLS_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Ленивые представления над Range и любыми контейнерами: ничего не выделяют и не копируют элементы,
+// а итераторы - шаблоны, так что цепочка Map(Filter(Range(n), ...), ...) встраивается в один цикл.
+// Переданный lvalue хранится по ссылке (он должен пережить представление), rvalue - по значению,
+// поэтому Map(Range(n), f) и Zip(std::vector<int>{...}, v) безопасны.
+// Итераторы однопроходные в смысле iterator_category, но копируются и сравниваются свободно;
+// каждый удовлетворяет std::input_iterator, так что представления вкладываются друг в друга и в std::ranges.
+
+namespace itertools_detail {
+
+template <typename R>
+using Stored = std::conditional_t<std::is_lvalue_reference_v<R>, R, std::remove_cvref_t<R>>;
+
+template <typename R>
+auto Begin(R &range) {
+  using std::begin;
+  return begin(range);
+}
+
+template <typename R>
+auto End(R &range) {
+  using std::end;
+  return end(range);
+}
+
+template <typename R>
+using IteratorOf = decltype(Begin(std::declval<std::remove_reference_t<R> &>()));
+
+template <typename R>
+using ReferenceOf = decltype(*std::declval<IteratorOf<R> &>());
+
+// Итератор и ссылка диапазона, переданного в представление как R
+template <typename R>
+using StoredIterator = IteratorOf<Stored<R>>;
+
+template <typename R>
+using StoredReference = ReferenceOf<Stored<R>>;
+
+} // namespace itertools_detail
+
+// Кортежи из i-х элементов всех диапазонов; заканчивается на самом коротком
+template <typename... Rs>
+class ZipView {
+private:
+  std::tuple<itertools_detail::Stored<Rs>...> ranges_;
+
+public:
+  class Iterator {
+  private:
+    std::tuple<itertools_detail::StoredIterator<Rs>...> its_{};
+
+  public:
+    using iterator_category = std::input_iterator_tag;                       // NOLINT
+    using value_type = std::tuple<itertools_detail::StoredReference<Rs>...>; // NOLINT
+    using difference_type = std::ptrdiff_t;                                  // NOLINT
+    using reference = value_type;                                            // NOLINT
+
+    Iterator() = default;
+    explicit Iterator(decltype(its_) its) : its_(std::move(its)) {}
+
+    reference operator*() const {
+      return std::apply([](const auto &...its) { return reference(*its...); }, its_);
+    }
+
+    Iterator &operator++() {
+      std::apply([](auto &...its) { (++its, ...); }, its_);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    // Равны, если совпал хотя бы один итератор: так цикл останавливается на самом коротком диапазоне
+    friend bool operator==(const Iterator &l, const Iterator &r) {
+      return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return ((std::get<I>(l.its_) == std::get<I>(r.its_)) || ...);
+      }(std::index_sequence_for<Rs...>{});
+    }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  explicit ZipView(Rs &&...ranges) : ranges_(std::forward<Rs>(ranges)...) {}
+
+  Iterator begin() { // NOLINT
+    return Iterator(
+        std::apply([](auto &...ranges) { return std::tuple(itertools_detail::Begin(ranges)...); }, ranges_));
+  }
+
+  Iterator end() { // NOLINT
+    return Iterator(
+        std::apply([](auto &...ranges) { return std::tuple(itertools_detail::End(ranges)...); }, ranges_));
+  }
+};
+
+// Пары (номер, элемент): for (auto [i, x] : Enumerate(v)); x - ссылка, если диапазон отдает ссылки
+template <typename R>
+class EnumerateView {
+private:
+  itertools_detail::Stored<R> range_;
+
+public:
+  class Iterator {
+  private:
+    itertools_detail::StoredIterator<R> it_{};
+    std::size_t index_ = 0;
+
+  public:
+    using iterator_category = std::input_iterator_tag;                                // NOLINT
+    using value_type = std::tuple<std::size_t, itertools_detail::StoredReference<R>>; // NOLINT
+    using difference_type = std::ptrdiff_t;                                           // NOLINT
+    using reference = value_type;                                                     // NOLINT
+
+    Iterator() = default;
+    Iterator(decltype(it_) it, std::size_t index) : it_(std::move(it)), index_(index) {}
+
+    reference operator*() const { return reference(index_, *it_); }
+
+    Iterator &operator++() {
+      ++it_;
+      ++index_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.it_ == r.it_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  explicit EnumerateView(R &&range) : range_(std::forward<R>(range)) {}
+
+  Iterator begin() { return {itertools_detail::Begin(range_), 0}; } // NOLINT
+  Iterator end() { return {itertools_detail::End(range_), 0}; }     // NOLINT
+};
+
+// fn(x) для каждого x, вычисляется при разыменовании
+template <typename R, typename F>
+class MapView {
+private:
+  itertools_detail::Stored<R> range_;
+  F fn_;
+
+public:
+  class Iterator {
+  private:
+    itertools_detail::StoredIterator<R> it_{};
+    const F *fn_ = nullptr;
+
+  public:
+    using iterator_category = std::input_iterator_tag;                                       // NOLINT
+    using reference = std::invoke_result_t<const F &, itertools_detail::StoredReference<R>>; // NOLINT
+    using value_type = std::remove_cvref_t<reference>;                                       // NOLINT
+    using difference_type = std::ptrdiff_t;                                                  // NOLINT
+
+    Iterator() = default;
+    Iterator(decltype(it_) it, const F *fn) : it_(std::move(it)), fn_(fn) {}
+
+    reference operator*() const { return std::invoke(*fn_, *it_); }
+
+    Iterator &operator++() {
+      ++it_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.it_ == r.it_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  MapView(R &&range, F fn) : range_(std::forward<R>(range)), fn_(std::move(fn)) {}
+
+  Iterator begin() { return {itertools_detail::Begin(range_), &fn_}; } // NOLINT
+  Iterator end() { return {itertools_detail::End(range_), &fn_}; }     // NOLINT
+};
+
+// Только элементы, для которых pred(x) истинно
+template <typename R, typename P>
+class FilterView {
+private:
+  itertools_detail::Stored<R> range_;
+  P pred_;
+
+public:
+  class Iterator {
+  private:
+    itertools_detail::StoredIterator<R> it_{};
+    itertools_detail::StoredIterator<R> end_{};
+    const P *pred_ = nullptr;
+
+    void Skip() {
+      while (it_ != end_ && !std::invoke(*pred_, *it_)) {
+        ++it_;
+      }
+    }
+
+  public:
+    using iterator_category = std::input_iterator_tag;      // NOLINT
+    using reference = itertools_detail::StoredReference<R>; // NOLINT
+    using value_type = std::remove_cvref_t<reference>;      // NOLINT
+    using difference_type = std::ptrdiff_t;                 // NOLINT
+
+    Iterator() = default;
+    Iterator(decltype(it_) it, decltype(end_) end, const P *pred)
+        : it_(std::move(it)), end_(std::move(end)), pred_(pred) {
+      Skip();
+    }
+
+    reference operator*() const { return *it_; }
+
+    Iterator &operator++() {
+      ++it_;
+      Skip();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.it_ == r.it_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  FilterView(R &&range, P pred) : range_(std::forward<R>(range)), pred_(std::move(pred)) {}
+
+  Iterator begin() { return {itertools_detail::Begin(range_), itertools_detail::End(range_), &pred_}; } // NOLINT
+  Iterator end() { return {itertools_detail::End(range_), itertools_detail::End(range_), &pred_}; }     // NOLINT
+};
+
+// Первые count элементов (или все, если их меньше)
+template <typename R>
+class TakeView {
+private:
+  itertools_detail::Stored<R> range_;
+  std::size_t count_;
+
+public:
+  class Iterator {
+  private:
+    itertools_detail::StoredIterator<R> it_{};
+    std::size_t left_ = 0;
+
+  public:
+    using iterator_category = std::input_iterator_tag;      // NOLINT
+    using reference = itertools_detail::StoredReference<R>; // NOLINT
+    using value_type = std::remove_cvref_t<reference>;      // NOLINT
+    using difference_type = std::ptrdiff_t;                 // NOLINT
+
+    Iterator() = default;
+    Iterator(decltype(it_) it, std::size_t left) : it_(std::move(it)), left_(left) {}
+
+    reference operator*() const { return *it_; }
+
+    Iterator &operator++() {
+      ++it_;
+      --left_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    // Конец - это либо исчерпанный счетчик, либо конец самого диапазона
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.left_ == r.left_ || l.it_ == r.it_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  TakeView(R &&range, std::size_t count) : range_(std::forward<R>(range)), count_(count) {}
+
+  Iterator begin() { return {itertools_detail::Begin(range_), count_}; } // NOLINT
+  Iterator end() { return {itertools_detail::End(range_), 0}; }          // NOLINT
+};
+
+// Подряд идущие куски по size элементов (последний может быть короче) как std::ranges::subrange
+template <typename R>
+class ChunkView {
+private:
+  itertools_detail::Stored<R> range_;
+  std::size_t size_;
+
+public:
+  class Iterator {
+  private:
+    using Base = itertools_detail::StoredIterator<R>;
+
+    Base it_{};
+    Base next_{};
+    Base end_{};
+    std::size_t size_ = 0;
+
+    // Для random-access диапазонов (Range, вектор) шаг к концу куска - O(1)
+    Base Advance(Base it) const {
+      if constexpr (std::random_access_iterator<Base>) {
+        const auto left = end_ - it;
+        return it + (left < static_cast<decltype(left)>(size_) ? left : static_cast<decltype(left)>(size_));
+      } else {
+        for (std::size_t i = 0; i < size_ && it != end_; ++i) {
+          ++it;
+        }
+        return it;
+      }
+    }
+
+  public:
+    using iterator_category = std::input_iterator_tag; // NOLINT
+    using value_type = std::ranges::subrange<Base>;    // NOLINT
+    using difference_type = std::ptrdiff_t;            // NOLINT
+    using reference = value_type;                      // NOLINT
+
+    Iterator() = default;
+    Iterator(Base it, Base end, std::size_t size) : it_(it), end_(end), size_(size) { next_ = Advance(it_); }
+
+    reference operator*() const { return {it_, next_}; }
+
+    Iterator &operator++() {
+      it_ = next_;
+      next_ = Advance(it_);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.it_ == r.it_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  ChunkView(R &&range, std::size_t size) : range_(std::forward<R>(range)), size_(size > 0 ? size : 1) {}
+
+  Iterator begin() { return {itertools_detail::Begin(range_), itertools_detail::End(range_), size_}; } // NOLINT
+  Iterator end() { return {itertools_detail::End(range_), itertools_detail::End(range_), size_}; }     // NOLINT
+};
+
+// Декартово произведение: кортежи перебираются как цифры счетчика, последний диапазон - младший разряд.
+// Диапазоны обходятся многократно, поэтому нужны многопроходные итераторы.
+template <typename... Rs>
+class ProductView {
+private:
+  using Iterators = std::tuple<itertools_detail::StoredIterator<Rs>...>;
+
+  std::tuple<itertools_detail::Stored<Rs>...> ranges_;
+
+public:
+  class Iterator {
+  private:
+    Iterators its_{};
+    Iterators begins_{};
+    Iterators ends_{};
+
+    template <std::size_t I>
+    void Increment() {
+      ++std::get<I>(its_);
+      if constexpr (I > 0) {
+        if (std::get<I>(its_) == std::get<I>(ends_)) {
+          std::get<I>(its_) = std::get<I>(begins_);
+          Increment<I - 1>();
+        }
+      }
+    }
+
+  public:
+    using iterator_category = std::input_iterator_tag;                       // NOLINT
+    using value_type = std::tuple<itertools_detail::StoredReference<Rs>...>; // NOLINT
+    using difference_type = std::ptrdiff_t;                                  // NOLINT
+    using reference = value_type;                                            // NOLINT
+
+    Iterator() = default;
+    Iterator(Iterators its, Iterators begins, Iterators ends)
+        : its_(std::move(its)), begins_(std::move(begins)), ends_(std::move(ends)) {}
+
+    reference operator*() const {
+      return std::apply([](const auto &...its) { return reference(*its...); }, its_);
+    }
+
+    Iterator &operator++() {
+      Increment<sizeof...(Rs) - 1>();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.its_ == r.its_; }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  explicit ProductView(Rs &&...ranges) : ranges_(std::forward<Rs>(ranges)...) {}
+
+  // Конец - первый диапазон в конце, остальные в начале; пустой сомножитель сразу дает конец
+  Iterator begin() { // NOLINT
+    Iterators begins = Begins();
+    Iterators ends = Ends();
+    const bool empty = [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return ((std::get<I>(begins) == std::get<I>(ends)) || ...);
+    }(std::index_sequence_for<Rs...>{});
+    return empty ? end() : Iterator(begins, begins, ends);
+  }
+
+  Iterator end() { // NOLINT
+    Iterators its = Begins();
+    std::get<0>(its) = std::get<0>(Ends());
+    return Iterator(its, Begins(), Ends());
+  }
+
+private:
+  Iterators Begins() {
+    return std::apply([](auto &...ranges) { return Iterators(itertools_detail::Begin(ranges)...); }, ranges_);
+  }
+
+  Iterators Ends() {
+    return std::apply([](auto &...ranges) { return Iterators(itertools_detail::End(ranges)...); }, ranges_);
+  }
+};
+
+// Сначала все элементы first, потом все элементы second; Chain(a, b, c) - это Chain(a, Chain(b, c))
+template <typename R1, typename R2>
+class ChainView {
+private:
+  itertools_detail::Stored<R1> first_;
+  itertools_detail::Stored<R2> second_;
+
+public:
+  class Iterator {
+  private:
+    itertools_detail::StoredIterator<R1> first_{};
+    itertools_detail::StoredIterator<R1> first_end_{};
+    itertools_detail::StoredIterator<R2> second_{};
+
+  public:
+    using iterator_category = std::input_iterator_tag; // NOLINT
+    using reference =                                  // NOLINT
+        std::common_reference_t<itertools_detail::StoredReference<R1>, itertools_detail::StoredReference<R2>>;
+    using value_type = std::remove_cvref_t<reference>; // NOLINT
+    using difference_type = std::ptrdiff_t;            // NOLINT
+
+    Iterator() = default;
+    Iterator(decltype(first_) first, decltype(first_end_) first_end, decltype(second_) second)
+        : first_(std::move(first)), first_end_(std::move(first_end)), second_(std::move(second)) {}
+
+    reference operator*() const {
+      if (first_ != first_end_) {
+        return *first_;
+      }
+      return *second_;
+    }
+
+    Iterator &operator++() {
+      if (first_ != first_end_) {
+        ++first_;
+      } else {
+        ++second_;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &l, const Iterator &r) {
+      return l.first_ == r.first_ && l.second_ == r.second_;
+    }
+  };
+
+  static_assert(std::input_iterator<Iterator>);
+
+  ChainView(R1 &&first, R2 &&second) : first_(std::forward<R1>(first)), second_(std::forward<R2>(second)) {}
+
+  Iterator begin() { // NOLINT
+    return {itertools_detail::Begin(first_), itertools_detail::End(first_), itertools_detail::Begin(second_)};
+  }
+
+  Iterator end() { // NOLINT
+    return {itertools_detail::End(first_), itertools_detail::End(first_), itertools_detail::End(second_)};
+  }
+};
+
+template <typename... Rs>
+ZipView<Rs...> Zip(Rs &&...ranges) {
+  return ZipView<Rs...>(std::forward<Rs>(ranges)...);
+}
+
+template <typename R>
+EnumerateView<R> Enumerate(R &&range) {
+  return EnumerateView<R>(std::forward<R>(range));
+}
+
+template <typename R, typename F>
+MapView<R, F> Map(R &&range, F fn) {
+  return MapView<R, F>(std::forward<R>(range), std::move(fn));
+}
+
+template <typename R, typename P>
+FilterView<R, P> Filter(R &&range, P pred) {
+  return FilterView<R, P>(std::forward<R>(range), std::move(pred));
+}
+
+template <typename R>
+TakeView<R> Take(R &&range, std::size_t count) {
+  return TakeView<R>(std::forward<R>(range), count);
+}
+
+template <typename R>
+ChunkView<R> Chunk(R &&range, std::size_t size) {
+  return ChunkView<R>(std::forward<R>(range), size);
+}
+
+template <typename... Rs>
+ProductView<Rs...> Product(Rs &&...ranges) {
+  return ProductView<Rs...>(std::forward<Rs>(ranges)...);
+}
+
+// Один диапазон возвращается как есть: lvalue - ссылкой, rvalue - по значению, чтобы не висеть
+template <typename R>
+itertools_detail::Stored<R> Chain(R &&range) {
+  return std::forward<R>(range);
+}
+
+template <typename R1, typename R2, typename... Rs>
+auto Chain(R1 &&first, R2 &&second, Rs &&...rest) {
+  return ChainView<R1, decltype(Chain(std::forward<R2>(second), std::forward<Rs>(rest)...))>(
+      std::forward<R1>(first), Chain(std::forward<R2>(second), std::forward<Rs>(rest)...));
+}
+
+#endif // ITERTOOLS_HPP
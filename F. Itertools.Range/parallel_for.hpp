@@ -0,0 +1,148 @@
+#ifndef PARALLEL_FOR_HPP
+#define PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "range.hpp"
+#include "thread_pool.hpp"
+
+// Параллельный обход Range в ThreadPool. Диапазон режется на куски через Slice, так что шаг
+// сохраняется, а каждый кусок обходится обычным циклом в одном потоке.
+//   kStatic  - поровну на каждый поток заранее, без общего счетчика;
+//   kDynamic - потоки берут куски по grain элементов из общего счетчика, пока они есть;
+//   kGuided  - то же, но кусок - доля оставшегося (не меньше grain): сначала крупно, к концу мелко.
+enum class Schedule { kStatic, kDynamic, kGuided };
+
+namespace parallel_for_detail {
+
+// 4096 элементов по 4-8 байт - примерно L1; меньше - и счетчик кусков становится заметен
+inline constexpr std::size_t kDefaultGrain = 4096;
+
+// Раздатчик номеров элементов для kDynamic и kGuided
+class ChunkDispenser {
+private:
+  std::atomic<std::size_t> next_{0};
+  std::size_t size_;
+  std::size_t grain_;
+  std::size_t workers_;
+  bool guided_;
+
+public:
+  ChunkDispenser(std::size_t size, std::size_t grain, std::size_t workers, bool guided)
+      : size_(size), grain_(grain), workers_(workers), guided_(guided) {}
+
+  bool Next(std::size_t &first, std::size_t &last) {
+    first = next_.load(std::memory_order_relaxed);
+    while (first < size_) {
+      const std::size_t left = size_ - first;
+      const std::size_t chunk = std::min(left, guided_ ? std::max(grain_, left / (2 * workers_)) : grain_);
+      if (next_.compare_exchange_weak(first, first + chunk, std::memory_order_relaxed)) {
+        last = first + chunk;
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Запускает worker(номер потока, число потоков) на workers потоках: один - вызывающий, остальные в пуле
+template <typename Worker>
+void RunWorkers(std::size_t workers, Worker &worker, ThreadPool &pool) {
+  TaskGroup group(pool);
+  for (std::size_t index = 1; index < workers; ++index) {
+    group.Run([&worker, index, workers] { worker(index, workers); });
+  }
+  worker(std::size_t{0}, workers);
+  group.Wait();
+}
+
+// Обрабатывает все куски, доставшиеся потоку index, отдавая их body как BasicRange
+template <typename IntT, typename Body>
+void ForEachChunk(const BasicRange<IntT> &range, Schedule schedule, std::size_t index, std::size_t workers,
+                  ChunkDispenser &dispenser, Body &body) {
+  const std::size_t size = range.Size();
+  if (schedule == Schedule::kStatic) {
+    body(range.Slice(size * index / workers, size * (index + 1) / workers));
+    return;
+  }
+  std::size_t first = 0;
+  std::size_t last = 0;
+  while (dispenser.Next(first, last)) {
+    body(range.Slice(first, last));
+  }
+}
+
+template <typename IntT>
+std::size_t WorkerCount(const BasicRange<IntT> &range, std::size_t grain, const ThreadPool &pool) {
+  const std::size_t chunks = (range.Size() + grain - 1) / grain;
+  return std::min<std::size_t>(chunks, pool.Size());
+}
+
+} // namespace parallel_for_detail
+
+// fn(x) для каждого x из range; порядок вызовов между кусками не определен
+template <typename IntT, typename F>
+void ParallelFor(const BasicRange<IntT> &range, F fn, Schedule schedule = Schedule::kDynamic,
+                 std::size_t grain = parallel_for_detail::kDefaultGrain, ThreadPool &pool = ThreadPool::Instance()) {
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t workers = parallel_for_detail::WorkerCount(range, grain, pool);
+  if (workers <= 1) {
+    for (IntT x : range) {
+      fn(x);
+    }
+    return;
+  }
+  parallel_for_detail::ChunkDispenser dispenser(range.Size(), grain, workers, schedule == Schedule::kGuided);
+  auto body = [&fn](const BasicRange<IntT> &chunk) {
+    for (IntT x : chunk) {
+      fn(x);
+    }
+  };
+  auto worker = [&](std::size_t index, std::size_t count) {
+    parallel_for_detail::ForEachChunk(range, schedule, index, count, dispenser, body);
+  };
+  parallel_for_detail::RunWorkers(workers, worker, pool);
+}
+
+// Свертка с частичным результатом на поток: acc = fn(acc, x) внутри потока, затем
+// combine(acc, acc) по номерам потоков. Для kStatic порядок, а значит и результат, детерминирован.
+template <typename IntT, typename T, typename F, typename Combine>
+T ParallelReduce(const BasicRange<IntT> &range, T identity, F fn, Combine combine,
+                 Schedule schedule = Schedule::kDynamic, std::size_t grain = parallel_for_detail::kDefaultGrain,
+                 ThreadPool &pool = ThreadPool::Instance()) {
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t workers = parallel_for_detail::WorkerCount(range, grain, pool);
+  if (workers <= 1) {
+    for (IntT x : range) {
+      identity = fn(std::move(identity), x);
+    }
+    return identity;
+  }
+  // Частичные результаты лежат по одному на кэш-линию, чтобы потоки не делили линии
+  struct alignas(64) Partial {
+    T value;
+  };
+  std::vector<Partial> partials(workers, Partial{identity});
+  parallel_for_detail::ChunkDispenser dispenser(range.Size(), grain, workers, schedule == Schedule::kGuided);
+  auto worker = [&](std::size_t index, std::size_t count) {
+    T acc = identity;
+    auto body = [&fn, &acc](const BasicRange<IntT> &chunk) {
+      for (IntT x : chunk) {
+        acc = fn(std::move(acc), x);
+      }
+    };
+    parallel_for_detail::ForEachChunk(range, schedule, index, count, dispenser, body);
+    partials[index].value = std::move(acc);
+  };
+  parallel_for_detail::RunWorkers(workers, worker, pool);
+  for (auto &partial : partials) {
+    identity = combine(std::move(identity), std::move(partial.value));
+  }
+  return identity;
+}
+
+#endif // PARALLEL_FOR_HPP
@@ -2,91 +2,223 @@
 #define RANGE_HPP
 #define REVERSE_RANGE_IMPLEMENTED
 
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <optional>
 #include <stdexcept>
+#include <type_traits>
 
 class ArrayOutOfRange : public std::out_of_range {
 public:
   ArrayOutOfRange() : std::out_of_range("ArrayOutOfRange") {}
 };
 
-class Iterator {
-private:
-  int data_ = 0;
-  int step_ = 0;
+// Диапазон над любым целым типом. Вся арифметика идет в беззнаковом UnsignedT (не уже unsigned,
+// чтобы короткие типы не продвигались в int): begin + i * step по модулю 2^N и приведение к IntT
+// дают точный элемент, даже когда промежуточные значения не влезают в IntT.
+// Шаг знаковый (StepType), так что и беззнаковые диапазоны можно обходить назад.
+template <typename IntT>
+class BasicRange {
+  static_assert(std::is_integral_v<IntT> && !std::is_same_v<IntT, bool>, "BasicRange requires an integral type");
 
 public:
-  Iterator(int data, int step) : data_(data), step_(step) {}
+  using UnsignedT = std::make_unsigned_t<std::common_type_t<IntT, unsigned>>;
+  using StepType = std::make_signed_t<IntT>;
+  using SizeType = UnsignedT;
+
+  // Сумма берется в типе вдвое шире IntT (для 64-битных - __int128, где он есть), так что
+  // сумма всего диапазона в него влезает
+#ifdef __SIZEOF_INT128__
+  using SumType = std::conditional_t<(sizeof(IntT) < 8),
+                                     std::conditional_t<std::is_signed_v<IntT>, long long, unsigned long long>,
+                                     std::conditional_t<std::is_signed_v<IntT>, __int128, unsigned __int128>>;
+  using WideUnsigned = std::conditional_t<(sizeof(IntT) < 8), unsigned long long, unsigned __int128>;
+  using DifferenceType = std::conditional_t<(sizeof(UnsignedT) < sizeof(std::ptrdiff_t)), std::ptrdiff_t, __int128>;
+#else
+  using SumType = std::conditional_t<std::is_signed_v<IntT>, long long, unsigned long long>;
+  using WideUnsigned = unsigned long long;
+  using DifferenceType = std::conditional_t<(sizeof(UnsignedT) < sizeof(std::ptrdiff_t)), std::ptrdiff_t, long long>;
+#endif
+
+  // Итератор хранит начало, шаг и номер элемента, так что сдвиг и разность - O(1).
+  // Сравниваются только номера: итераторы одного диапазона, а конец - это номер Size().
+  // Номер беззнаковый, как Size(), а разность берется в DifferenceType шире UnsignedT, так что
+  // и диапазон из 2^64 - 1 элементов обходится без переполнения (без __int128 - до 2^63).
+  class Iterator {
+  private:
+    UnsignedT begin_ = 0;
+    UnsignedT step_ = 0;
+    UnsignedT index_ = 0;
+
+  public:
+    // reference - prvalue IntT, как у итераторов по вычисляемым последовательностям. Формально
+    // это не LegacyForwardIterator, но std::distance, std::advance и std::sort должны видеть
+    // произвольный доступ и не ходить по элементам по одному, поэтому категория тоже random access.
+    using iterator_concept = std::random_access_iterator_tag;  // NOLINT
+    using iterator_category = std::random_access_iterator_tag; // NOLINT
+    using value_type = IntT;                                   // NOLINT
+    using difference_type = DifferenceType;                    // NOLINT
+    using reference = IntT;                                    // NOLINT
+
+    Iterator() = default;
+    Iterator(UnsignedT begin, UnsignedT step, UnsignedT index = 0) : begin_(begin), step_(step), index_(index) {}
+
+    IntT operator*() const { return static_cast<IntT>(begin_ + index_ * step_); }
+    IntT operator[](DifferenceType offset) const { return *(*this + offset); }
+
+    Iterator &operator++() {
+      ++index_;
+      return *this;
+    }
 
-  int operator*() const { return data_; }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++index_;
+      return old;
+    }
 
-  Iterator &operator++() {
-    data_ += step_;
-    return *this;
-  }
+    Iterator &operator--() {
+      --index_;
+      return *this;
+    }
 
-  bool operator!=(const Iterator &other) const {
-    if (step_ > 0) {
-      return data_ < other.data_;
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --index_;
+      return old;
+    }
+
+    // Отрицательный сдвиг по модулю 2^N - то же вычитание
+    Iterator &operator+=(DifferenceType offset) {
+      index_ += static_cast<UnsignedT>(offset);
+      return *this;
+    }
+
+    Iterator &operator-=(DifferenceType offset) {
+      index_ -= static_cast<UnsignedT>(offset);
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator it, DifferenceType offset) { return it += offset; }
+    friend Iterator operator+(DifferenceType offset, Iterator it) { return it += offset; }
+    friend Iterator operator-(Iterator it, DifferenceType offset) { return it -= offset; }
+    friend DifferenceType operator-(const Iterator &l, const Iterator &r) {
+      return static_cast<DifferenceType>(l.index_) - static_cast<DifferenceType>(r.index_);
     }
-    return data_ > other.data_;
-  }
-};
 
-class Range {
+    friend bool operator==(const Iterator &l, const Iterator &r) { return l.index_ == r.index_; }
+    friend std::strong_ordering operator<=>(const Iterator &l, const Iterator &r) { return l.index_ <=> r.index_; }
+  };
+
 private:
-  int begin_ = 0;
-  int end_ = 0;
-  int step_ = 1;
-  bool flag_ = false;
+  UnsignedT begin_ = 0;
+  UnsignedT step_ = 1;
+  SizeType size_ = 0;
 
 public:
-  explicit Range(int end) : Range(0, end, 1) {}
-  Range(int begin, int end) : Range(begin, end, 1) {}
+  explicit BasicRange(IntT end) : BasicRange(0, end, 1) {}
+  BasicRange(IntT begin, IntT end) : BasicRange(begin, end, 1) {}
 
-  Range(int begin, int end, int step) : begin_(begin), end_(end), step_(step) {
+  // Расстояние между концами - беззнаковая разность, она точна для любых begin и end;
+  // (distance - 1) / |step| + 1 не переполняется даже при distance = 2^N - 1
+  BasicRange(IntT begin, IntT end, StepType step)
+      : begin_(static_cast<UnsignedT>(begin)), step_(static_cast<UnsignedT>(step)) {
     if (step == 0) {
-      flag_ = true;
-      begin_ = end_ = 0;
+      begin_ = 0;
       step_ = 1;
-    } else if ((step < 0 && begin <= end) || (step > 0 && begin >= end)) {
-      flag_ = true;
+    } else if (step > 0 && begin < end) {
+      size_ = (static_cast<UnsignedT>(end) - begin_ - 1) / step_ + 1;
+    } else if (step < 0 && begin > end) {
+      size_ = (begin_ - static_cast<UnsignedT>(end) - 1) / (UnsignedT{0} - step_) + 1;
     }
   }
 
-  Iterator begin() const { // NOLINT
-    if (flag_) {
-      return {0, step_};
-    }
-    return {begin_, step_};
+  SizeType Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+
+  IntT operator[](SizeType index) const { return static_cast<IntT>(begin_ + index * step_); }
+
+  // Элементы с номерами [first, last) - диапазон с тем же шагом; номера за концом обрезаются
+  BasicRange Slice(SizeType first, SizeType last) const {
+    last = last < size_ ? last : size_;
+    first = first < last ? first : last;
+    BasicRange slice(*this);
+    slice.begin_ = begin_ + first * step_;
+    slice.size_ = last - first;
+    return slice;
   }
 
-  Iterator end() const { // NOLINT
-    if (flag_) {
-      return {0, step_};
-    }
-    return {end_, step_};
+  Iterator begin() const { return {begin_, step_}; } // NOLINT
+  Iterator end() const { return {begin_, step_, size_}; } // NOLINT
+
+  // Обратный обход - тот же итератор, идущий от последнего элемента с шагом -step_
+  Iterator rbegin() const { return {Last(), UnsignedT{0} - step_}; } // NOLINT
+  Iterator rend() const { return {Last(), UnsignedT{0} - step_, size_}; } // NOLINT
+
+  // Число элементов, как len() у range в Python
+  SizeType Count() const { return size_; }
+
+  // n * begin + step * n (n - 1) / 2 по модулю 2^N в WideUnsigned: настоящая сумма в SumType
+  // влезает, поэтому результат точен. Четный из n и n - 1 делится пополам до умножения.
+  SumType Sum() const {
+    using Wide = WideUnsigned;
+    const Wide n = size_;
+    const Wide pairs = n % 2 == 0 ? n / 2 * (n - 1) : (n - 1) / 2 * n;
+    const Wide first = static_cast<Wide>(static_cast<SumType>(static_cast<IntT>(begin_)));
+    const Wide step = static_cast<Wide>(static_cast<SumType>(static_cast<StepType>(step_)));
+    return static_cast<SumType>(n * first + pairs * step);
   }
 
-  Iterator rbegin() const { // NOLINT
-    if (flag_) {
-      return {0, -step_};
+  bool Contains(IntT value) const { return IndexOf(value).has_value(); }
+
+  // Номер value в диапазоне за O(1): value должно лежать между первым и последним элементом
+  // и отстоять от первого на целое число шагов
+  std::optional<SizeType> IndexOf(IntT value) const {
+    if (size_ == 0) {
+      return std::nullopt;
     }
-    int delta = end_ - begin_;
-    int count = delta / step_;
-    if (delta % step_ != 0) {
-      ++count;
+    const IntT first = static_cast<IntT>(begin_);
+    const bool forward = static_cast<std::make_signed_t<UnsignedT>>(step_) > 0;
+    if (forward ? value < first : value > first) {
+      return std::nullopt;
     }
-
-    int last = begin_ + (count - 1) * step_;
-    return {last, -step_};
+    const UnsignedT distance =
+        forward ? static_cast<UnsignedT>(value) - begin_ : begin_ - static_cast<UnsignedT>(value);
+    const UnsignedT stride = forward ? step_ : UnsignedT{0} - step_;
+    if (distance % stride != 0 || distance / stride >= size_) {
+      return std::nullopt;
+    }
+    return distance / stride;
   }
 
-  Iterator rend() const { // NOLINT
-    if (flag_) {
-      return {0, -step_};
+  // Пишет Size() элементов в out. Восемь дорожек по восемь элементов за шаг сдвигаются на 8 * step
+  // сложением без зависимостей между дорожками, и компилятор превращает блок в векторные сложения.
+  template <typename T>
+  void FillInto(T *out) const {
+    constexpr SizeType kLanes = 8;
+    UnsignedT lanes[kLanes];
+    for (SizeType k = 0; k < kLanes; ++k) {
+      lanes[k] = begin_ + k * step_;
+    }
+    const UnsignedT stride = kLanes * step_;
+    SizeType i = 0;
+    for (; i + kLanes <= size_; i += kLanes) {
+      for (SizeType k = 0; k < kLanes; ++k) {
+        out[i + k] = static_cast<T>(static_cast<IntT>(lanes[k]));
+        lanes[k] += stride;
+      }
+    }
+    for (; i < size_; ++i) {
+      out[i] = (*this)[i];
     }
-    return {begin_ - step_, -step_};
   }
+
+private:
+  UnsignedT Last() const { return size_ == 0 ? begin_ : begin_ + (size_ - 1) * step_; }
 };
 
+using Range = BasicRange<int>;
+using Iterator = Range::Iterator;
+
 #endif // RANGE_HPP //
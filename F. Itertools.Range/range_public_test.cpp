@@ -1,9 +1,25 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include "arange.hpp"
+#include "itertools.hpp"
+#include "parallel_for.hpp"
 #include "range.hpp"
 #include "range.hpp"  // check include guards
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 TEST_CASE("End", "[Range]") {
   const int end = 5;
 
@@ -317,6 +333,440 @@ TEST_CASE("SequenceIsGenerated", "[Range]") {
   }
 }
 
+TEST_CASE("RandomAccess", "[Range]") {
+  static_assert(std::random_access_iterator<Iterator>);
+  static_assert(std::ranges::random_access_range<Range>);
+  static_assert(std::ranges::sized_range<Range>);
+  static_assert(
+      std::is_same_v<std::iterator_traits<Iterator>::iterator_category, std::random_access_iterator_tag>);
+
+  const auto range = Range(-7, 19, 5);
+  REQUIRE(range.Size() == 6);
+  REQUIRE(std::ranges::size(range) == 6);
+  REQUIRE(std::distance(range.begin(), range.end()) == 6);
+  for (Range::SizeType i = 0; i < range.Size(); ++i) {
+    REQUIRE(range[i] == -7 + static_cast<int>(i) * 5);
+    REQUIRE(range.begin()[i] == range[i]);
+    REQUIRE(*(range.begin() + i) == range[i]);
+    REQUIRE(*(range.end() - (range.Size() - i)) == range[i]);
+  }
+
+  auto it = range.begin();
+  it += 4;
+  REQUIRE(*it == 13);
+  it -= 3;
+  REQUIRE(*it == -2);
+  REQUIRE(range.begin() < it);
+  REQUIRE(it <= range.end());
+  REQUIRE(range.end() - it == 5);
+  REQUIRE(*std::ranges::lower_bound(range, 4) == 8);
+  REQUIRE(*std::lower_bound(range.begin(), range.end(), 4) == 8);
+  auto far = range.begin();
+  std::advance(far, 5);
+  REQUIRE(*far == 18);
+  REQUIRE(*std::prev(far, 2) == 8);
+
+  REQUIRE(Range(8, -14, -4).Size() == 6);
+  REQUIRE(Range(8, -14, -4)[5] == -12);
+  REQUIRE(Range(2, 7, -3).Size() == 0);
+  REQUIRE(Range(2, 5, 0).Size() == 0);
+  REQUIRE(Range(2, 5, 0).begin() == Range(2, 5, 0).end());
+
+  const auto huge = Range(std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), -1);
+  REQUIRE(huge.Size() == 4294967295LL);
+  REQUIRE(huge[huge.Size() - 1] == std::numeric_limits<int>::min() + 1);
+}
+
+TEST_CASE("Slice", "[Range]") {
+  const auto range = Range(10, -10, -3);
+  const auto slice = range.Slice(2, 5);
+  REQUIRE(std::vector<int>(slice.begin(), slice.end()) == std::vector<int>{4, 1, -2});
+  REQUIRE(range.Slice(5, 100).Size() == 2);
+  REQUIRE(range.Slice(100, 200).Empty());
+  REQUIRE(range.Slice(4, 2).Empty());
+}
+
+TEST_CASE("Integral", "[Range]") {
+  const int64_t big = int64_t{1} << 40;
+  const auto offsets = BasicRange<int64_t>(big, 3 * big, big / 2);
+  REQUIRE(offsets.Size() == 4);
+  REQUIRE(offsets[3] == big + 3 * (big / 2));
+  REQUIRE(*offsets.rbegin() == offsets[3]);
+
+  const auto all = BasicRange<int64_t>(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+  REQUIRE(all.Size() == std::numeric_limits<uint64_t>::max());
+  REQUIRE(all[all.Size() - 1] == std::numeric_limits<int64_t>::max() - 1);
+  // Size() больше PTRDIFF_MAX, но итераторы с ним согласны
+  static_assert(std::random_access_iterator<BasicRange<int64_t>::Iterator>);
+  using Difference = BasicRange<int64_t>::DifferenceType;
+  REQUIRE((all.end() - all.begin() == static_cast<Difference>(all.Size())));
+  REQUIRE((all.begin() - all.end() == -static_cast<Difference>(all.Size())));
+  REQUIRE(all.begin() < all.end());
+  REQUIRE(std::ranges::size(all) == all.Size());
+  REQUIRE(*(all.end() - 1) == std::numeric_limits<int64_t>::max() - 1);
+  REQUIRE(*std::prev(all.end(), 2) == std::numeric_limits<int64_t>::max() - 2);
+  REQUIRE(all.begin()[static_cast<Difference>(all.Size() / 2 + 1)] == 0);
+  REQUIRE(*(all.end() + -static_cast<Difference>(all.Size())) == std::numeric_limits<int64_t>::min());
+  REQUIRE(*all.rbegin() == std::numeric_limits<int64_t>::max() - 1);
+  REQUIRE((all.rend() - all.rbegin() == static_cast<Difference>(all.Size())));
+  int64_t expected = std::numeric_limits<int64_t>::min();
+  for (auto x : all) {
+    REQUIRE(x == expected);
+    if (++expected == std::numeric_limits<int64_t>::min() + 3) {
+      break;
+    }
+  }
+
+  const auto wide = BasicRange<int64_t>(std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+                                        std::numeric_limits<int64_t>::min());
+  REQUIRE(wide.Size() == 2);
+  REQUIRE(wide[1] == -1);
+  REQUIRE(*wide.rbegin() == -1);
+
+  const auto down = BasicRange<uint64_t>(10, 0, -3);
+  REQUIRE(down.Size() == 4);
+  REQUIRE(std::vector<uint64_t>(down.begin(), down.end()) == std::vector<uint64_t>{10, 7, 4, 1});
+  REQUIRE(std::vector<uint64_t>(down.rbegin(), down.rend()) == std::vector<uint64_t>{1, 4, 7, 10});
+
+  const uint64_t max = std::numeric_limits<uint64_t>::max();
+  const auto top = BasicRange<uint64_t>(max - 5, max, 2);
+  REQUIRE(std::vector<uint64_t>(top.begin(), top.end()) == std::vector<uint64_t>{max - 5, max - 3, max - 1});
+
+  const auto tiny = BasicRange<int8_t>(-128, 127, 51);
+  REQUIRE(std::vector<int8_t>(tiny.begin(), tiny.end()) == std::vector<int8_t>{-128, -77, -26, 25, 76});
+  REQUIRE(*tiny.rbegin() == 76);
+
+  const auto extreme = Range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+                             std::numeric_limits<int>::max());
+  REQUIRE(std::vector<int>(extreme.rbegin(), extreme.rend()) ==
+          std::vector<int>{std::numeric_limits<int>::max() - 1, -1, std::numeric_limits<int>::min()});
+}
+
+TEST_CASE("ClosedForm", "[Range]") {
+  for (const auto &range : {Range(-7, 19, 5), Range(8, -14, -4), Range(5), Range(2, 7, -3), Range(2, 5, 0)}) {
+    long long sum = 0;
+    for (auto x : range) {
+      sum += x;
+    }
+    REQUIRE(range.Sum() == sum);
+    REQUIRE(range.Count() == range.Size());
+    for (int x = -20; x <= 20; ++x) {
+      const auto index = range.IndexOf(x);
+      const auto found = std::find(range.begin(), range.end(), x);
+      REQUIRE(range.Contains(x) == (found != range.end()));
+      REQUIRE(index.has_value() == range.Contains(x));
+      if (index) {
+        REQUIRE(static_cast<std::ptrdiff_t>(*index) == found - range.begin());
+      }
+    }
+  }
+
+  const auto huge = Range(std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), -1);
+  REQUIRE(huge.Sum() == 0);
+  REQUIRE(huge.IndexOf(std::numeric_limits<int>::min() + 1) == huge.Size() - 1);
+  REQUIRE_FALSE(huge.Contains(std::numeric_limits<int>::min()));
+
+  const auto down = BasicRange<uint64_t>(10, 0, -3);
+  REQUIRE(down.Sum() == 22);
+  REQUIRE(down.IndexOf(4) == 2u);
+  REQUIRE_FALSE(down.Contains(5));
+  REQUIRE_FALSE(down.Contains(13));
+
+  const auto all = BasicRange<int64_t>(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+  using SumType = BasicRange<int64_t>::SumType;
+  const SumType expected = SumType{std::numeric_limits<int64_t>::min()} - std::numeric_limits<int64_t>::max();
+  REQUIRE((all.Sum() == expected));
+}
+
+TEST_CASE("FillInto", "[Range]") {
+  for (const auto &range : {Range(-7, 19, 5), Range(100, -100, -3), Range(3), Range(0)}) {
+    std::vector<long long> out(range.Size());
+    range.FillInto(out.data());
+    REQUIRE(out == std::vector<long long>(range.begin(), range.end()));
+  }
+
+  const auto bytes = BasicRange<uint8_t>(250, 0, -7);
+  std::vector<uint8_t> out(bytes.Size());
+  bytes.FillInto(out.data());
+  REQUIRE(out == std::vector<uint8_t>(bytes.begin(), bytes.end()));
+
+  std::vector<double> grid(40);
+  Range(0, 400, 10).FillInto(grid.data());
+  REQUIRE(grid[39] == 390.0);
+}
+
+TEST_CASE("ParallelFor", "[Parallel]") {
+  ThreadPool pool(4);
+  const Range ranges[] = {Range(-1000, 1000, 7), Range(1000, -1000, -13), Range(0), Range(5, 6), Range(2, 5, 0)};
+  for (const auto schedule : {Schedule::kStatic, Schedule::kDynamic, Schedule::kGuided}) {
+    for (const std::size_t grain : {0, 1, 3, 64, 4096}) {
+      for (const auto &range : ranges) {
+        std::vector<std::atomic<int>> visits(range.Size());
+        std::atomic<int> broken = 0;
+        ParallelFor(
+            range,
+            [&](int x) {
+              const auto index = range.IndexOf(x);
+              if (!index) {
+                ++broken;
+                return;
+              }
+              ++visits[*index];
+            },
+            schedule, grain, pool);
+        REQUIRE(broken == 0);
+        REQUIRE(std::all_of(visits.begin(), visits.end(), [](const auto &count) { return count == 1; }));
+
+        const auto sum = ParallelReduce(
+            range, 0LL, [](long long acc, int x) { return acc + x; },
+            [](long long l, long long r) { return l + r; }, schedule, grain, pool);
+        REQUIRE(sum == range.Sum());
+
+        // Некоммутативная свертка: для kStatic куски склеиваются по порядку
+        const auto seq = ParallelReduce(
+            range, std::vector<int>{},
+            [](std::vector<int> acc, int x) {
+              acc.push_back(x);
+              return acc;
+            },
+            [](std::vector<int> l, const std::vector<int> &r) {
+              l.insert(l.end(), r.begin(), r.end());
+              return l;
+            },
+            schedule, grain, pool);
+        auto sorted = seq;
+        std::sort(sorted.begin(), sorted.end());
+        auto expected = std::vector<int>(range.begin(), range.end());
+        if (schedule == Schedule::kStatic) {
+          REQUIRE(seq == expected);
+        }
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(sorted == expected);
+      }
+    }
+  }
+}
+
+namespace {
+
+template <typename View>
+auto Collect(View &&view) {
+  std::vector<std::remove_cvref_t<decltype(*view.begin())>> out;
+  for (auto &&x : view) {
+    out.push_back(x);
+  }
+  return out;
+}
+
+} // namespace
+
+TEST_CASE("Views", "[Itertools]") {
+  std::vector<int> v = {3, 1, 4, 1, 5};
+
+  REQUIRE(Collect(Map(Range(4), [](int x) { return x * x; })) == std::vector<int>{0, 1, 4, 9});
+  REQUIRE(Collect(Filter(v, [](int x) { return x > 2; })) == std::vector<int>{3, 4, 5});
+  REQUIRE(Collect(Take(Range(100), 3)) == std::vector<int>{0, 1, 2});
+  REQUIRE(Collect(Take(v, 100)) == v);
+  REQUIRE(Collect(Take(v, 0)).empty());
+  REQUIRE(Collect(Chain(Range(2), v, Range(7, 9))) == std::vector<int>{0, 1, 3, 1, 4, 1, 5, 7, 8});
+  REQUIRE(Collect(Chain(Range(3))) == std::vector<int>{0, 1, 2});
+  REQUIRE(Collect(Enumerate(Range(5, 8))) ==
+          std::vector<std::tuple<std::size_t, int>>{{0, 5}, {1, 6}, {2, 7}});
+  REQUIRE(Collect(Product(Range(2), Range(3))) ==
+          std::vector<std::tuple<int, int>>{{0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1}, {1, 2}});
+
+  std::vector<std::vector<int>> chunks;
+  for (auto chunk : Chunk(v, 2)) {
+    chunks.emplace_back(chunk.begin(), chunk.end());
+  }
+  REQUIRE(chunks == std::vector<std::vector<int>>{{3, 1}, {4, 1}, {5}});
+
+  // Одно и то же представление можно обходить несколько раз, постфиксный ++ отдает старую позицию
+  auto squares = Map(Range(3), [](int x) { return x * x; });
+  auto it = squares.begin();
+  REQUIRE(*it++ == 0);
+  REQUIRE(*it == 1);
+  REQUIRE(Collect(squares) == Collect(squares));
+  decltype(it) unset;
+  unset = it;
+  REQUIRE(unset == it);
+}
+
+TEST_CASE("ViewsAreInputRanges", "[Itertools]") {
+  std::vector<int> v;
+  auto square = [](int x) { return x * x; };
+  auto odd = [](int x) { return x % 2 != 0; };
+  static_assert(std::ranges::input_range<decltype(Zip(v, Range(3)))>);
+  static_assert(std::ranges::input_range<decltype(Enumerate(v))>);
+  static_assert(std::ranges::input_range<decltype(Map(Range(3), square))>);
+  static_assert(std::ranges::input_range<decltype(Filter(v, odd))>);
+  static_assert(std::ranges::input_range<decltype(Take(v, 2))>);
+  static_assert(std::ranges::input_range<decltype(Chunk(Map(Range(10), square), 3))>);
+  static_assert(std::ranges::input_range<decltype(Product(v, Range(3)))>);
+  static_assert(std::ranges::input_range<decltype(Chain(v, Range(3)))>);
+  static_assert(std::is_same_v<decltype(Chain(v)), std::vector<int> &>);
+  static_assert(std::is_same_v<decltype(Chain(Range(3))), Range>);
+
+  std::vector<int> out;
+  std::ranges::copy(Filter(Range(10), odd), std::back_inserter(out));
+  REQUIRE(out == std::vector<int>{1, 3, 5, 7, 9});
+}
+
+TEST_CASE("NestedViews", "[Itertools]") {
+  auto square = [](int x) { return x * x; };
+  std::vector<std::vector<int>> chunks;
+  for (auto chunk : Chunk(Map(Range(10), square), 3)) {
+    chunks.emplace_back(chunk.begin(), chunk.end());
+  }
+  REQUIRE(chunks == std::vector<std::vector<int>>{{0, 1, 4}, {9, 16, 25}, {36, 49, 64}, {81}});
+
+  std::vector<int> sums;
+  for (auto chunk : Chunk(Filter(Map(Range(20), square), [](int x) { return x % 2 == 0; }), 4)) {
+    int sum = 0;
+    for (int x : chunk) {
+      sum += x;
+    }
+    sums.push_back(sum);
+  }
+  REQUIRE(sums == std::vector<int>{0 + 4 + 16 + 36, 64 + 100 + 144 + 196, 256 + 324});
+
+  std::vector<char> letters = {'a', 'b', 'c'};
+  std::vector<std::pair<std::size_t, char>> pairs;
+  for (auto chunk : Chunk(Enumerate(letters), 2)) {
+    for (auto [i, c] : chunk) {
+      pairs.emplace_back(i, c);
+    }
+  }
+  REQUIRE(pairs == std::vector<std::pair<std::size_t, char>>{{0, 'a'}, {1, 'b'}, {2, 'c'}});
+
+  REQUIRE(Collect(Map(Zip(Range(3), Range(10, 20)), [](auto t) { return std::get<0>(t) + std::get<1>(t); })) ==
+          std::vector<int>{10, 12, 14});
+}
+
+TEST_CASE("EmptyViews", "[Itertools]") {
+  const std::vector<int> empty;
+  auto identity = [](int x) { return x; };
+  REQUIRE(Collect(Map(empty, identity)).empty());
+  REQUIRE(Collect(Filter(Range(0), identity)).empty());
+  REQUIRE(Collect(Filter(Range(5), [](int) { return false; })).empty());
+  REQUIRE(Collect(Take(empty, 3)).empty());
+  REQUIRE(Collect(Enumerate(empty)).empty());
+  REQUIRE(Collect(Zip(empty, Range(3))).empty());
+  REQUIRE(Collect(Chain(empty, Range(0))).empty());
+  REQUIRE(Collect(Chain(empty, Range(2))) == std::vector<int>{0, 1});
+  REQUIRE(Chunk(empty, 3).begin() == Chunk(empty, 3).end());
+  REQUIRE(Collect(Product(Range(3), empty)).empty());
+  REQUIRE(Collect(Product(empty, Range(3))).empty());
+  REQUIRE(Collect(Product(Range(2), Range(0), Range(2))).empty());
+}
+
+TEST_CASE("ZipUnequal", "[Itertools]") {
+  std::vector<int> shorter = {1, 2};
+  auto pairs = [](auto &&view) {
+    std::vector<std::pair<int, int>> out;
+    for (auto [l, r] : view) {
+      out.emplace_back(l, r);
+    }
+    return out;
+  };
+  REQUIRE(pairs(Zip(shorter, Range(10))) == std::vector<std::pair<int, int>>{{1, 0}, {2, 1}});
+  REQUIRE(pairs(Zip(Range(10), shorter)) == std::vector<std::pair<int, int>>{{0, 1}, {1, 2}});
+  REQUIRE(Collect(Zip(Range(3), Range(5), Range(4))).size() == 3);
+}
+
+TEST_CASE("WriteThroughViews", "[Itertools]") {
+  std::vector<int> v = {1, 2, 3};
+  for (auto [i, x] : Enumerate(v)) {
+    x *= static_cast<int>(i) + 1;
+  }
+  REQUIRE(v == std::vector<int>{1, 4, 9});
+
+  std::vector<int> w(3);
+  for (auto [from, to] : Zip(v, w)) {
+    to = from + 1;
+  }
+  REQUIRE(w == std::vector<int>{2, 5, 10});
+
+  for (auto &x : Filter(v, [](int x) { return x > 1; })) {
+    x = 0;
+  }
+  REQUIRE(v == std::vector<int>{1, 0, 0});
+}
+
+TEST_CASE("Arange", "[Arange]") {
+  static_assert(std::ranges::random_access_range<Arange<double>>);
+  static_assert(std::is_same_v<std::iterator_traits<Arange<double>::Iterator>::iterator_category,
+                               std::random_access_iterator_tag>);
+
+  const auto grid = Arange(0.0, 100.0, 0.1);
+  REQUIRE(grid.Size() == 1000);
+  // Каждый элемент - одно умножение, без накопления ошибки при обходе
+  std::size_t i = 0;
+  for (double x : grid) {
+    REQUIRE(x == 0.0 + static_cast<double>(i) * 0.1);
+    ++i;
+  }
+  REQUIRE(i == grid.Size());
+  REQUIRE(grid.end() - grid.begin() == 1000);
+  REQUIRE(grid.begin()[10] == grid[10]);
+
+  REQUIRE(Arange(1.0, 0.0, 0.5).Empty());
+  REQUIRE(Arange(0.0, 1.0, 0.0).Empty());
+  REQUIRE(Arange(0.0, std::numeric_limits<double>::infinity(), 1.0).Empty());
+  REQUIRE(std::vector<double>(Arange(1.0, 0.0, -0.25).begin(), Arange(1.0, 0.0, -0.25).end()) ==
+          std::vector<double>{1.0, 0.75, 0.5, 0.25});
+  REQUIRE_THROWS_AS(Arange(0.0, 1e30, 1e-30), std::length_error);
+  REQUIRE_THROWS_AS(Arange(0.0, 1e19, 1.0), std::length_error);
+  REQUIRE_THROWS_AS(Linspace(0.0, 1.0, std::numeric_limits<std::size_t>::max()), std::length_error);
+
+  const auto ints = Arange(std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+                           std::numeric_limits<int>::max());
+  REQUIRE(std::vector<int>(ints.begin(), ints.end()) ==
+          std::vector<int>{std::numeric_limits<int>::min(), -1, std::numeric_limits<int>::max() - 1});
+  // Целая сетка длиннее PTRDIFF_MAX, как у BasicRange
+  const auto all = Arange(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+  using Difference = Arange<int64_t>::DifferenceType;
+  REQUIRE(all.Size() == std::numeric_limits<uint64_t>::max());
+  REQUIRE((all.end() - all.begin() == static_cast<Difference>(all.Size())));
+  REQUIRE(*(all.end() - 1) == std::numeric_limits<int64_t>::max() - 1);
+  REQUIRE(*all.begin() == std::numeric_limits<int64_t>::min());
+  const auto bytes = Arange<int8_t>(-128, 127, 51);
+  REQUIRE(std::vector<int8_t>(bytes.begin(), bytes.end()) == std::vector<int8_t>{-128, -77, -26, 25, 76});
+}
+
+TEST_CASE("Linspace", "[Arange]") {
+  const auto closed = Linspace(0.0, 1.0, 5);
+  REQUIRE(std::vector<double>(closed.begin(), closed.end()) == std::vector<double>{0.0, 0.25, 0.5, 0.75, 1.0});
+  const auto open = Linspace(0.0, 1.0, 4, false);
+  REQUIRE(std::vector<double>(open.begin(), open.end()) == std::vector<double>{0.0, 0.25, 0.5, 0.75});
+
+  // Последняя точка - ровно end, даже когда шаг не представим точно
+  const auto tenths = Linspace(0.1, 0.7, 7);
+  REQUIRE(tenths[6] == 0.7);
+  for (std::size_t i = 0; i + 1 < tenths.Size(); ++i) {
+    REQUIRE(tenths[i] == 0.1 + static_cast<double>(i) * tenths.Step());
+  }
+
+  for (const bool endpoint : {true, false}) {
+    REQUIRE(Linspace(2.0, 3.0, 0, endpoint).Empty());
+    const auto single = Linspace(2.0, 3.0, 1, endpoint);
+    REQUIRE(single.Size() == 1);
+    REQUIRE(*single.begin() == 2.0);
+  }
+}
+
+TEST_CASE("ArangeFillInto", "[Arange]") {
+  for (const auto &grid : {Arange(0.0, 100.0, 0.1), Linspace(-1.0, 1.0, 17), Linspace(0.0, 1.0, 3, false),
+                           Linspace(0.0, 1.0, 0), Arange(0.0, 1.0, 0.125)}) {
+    std::vector<double> out(grid.Size());
+    grid.FillInto(out.data());
+    REQUIRE(out == std::vector<double>(grid.begin(), grid.end()));
+  }
+  std::vector<float> narrow(9);
+  Linspace(0.0, 2.0, 9).FillInto(narrow.data());
+  REQUIRE(narrow.back() == 2.0f);
+}
+
 #ifdef REVERSE_RANGE_IMPLEMENTED
 
 TEST_CASE("ReverseEnd", "[ReverseRange]") {